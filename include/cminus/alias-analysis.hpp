@@ -0,0 +1,128 @@
+#pragma once
+#include <cminus/ast.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cminus
+{
+/// How some code may access a variable.
+enum class ModRef : uint8_t
+{
+    /// Neither modifies nor references the variable.
+    None = 0,
+
+    /// May reference (read) the variable.
+    Ref = (1 << 0),
+
+    /// May modify (write) the variable.
+    Mod = (1 << 1),
+
+    /// May both modify and reference the variable.
+    ModRef = Mod | Ref,
+};
+
+constexpr ModRef operator|(ModRef lhs, ModRef rhs)
+{
+    return static_cast<ModRef>(
+            static_cast<uint8_t>(lhs) | static_cast<uint8_t>(rhs));
+}
+
+constexpr ModRef operator&(ModRef lhs, ModRef rhs)
+{
+    return static_cast<ModRef>(
+            static_cast<uint8_t>(lhs) & static_cast<uint8_t>(rhs));
+}
+
+constexpr bool operator!(ModRef value)
+{
+    return !(static_cast<uint8_t>(value));
+}
+
+/// Alias analysis of the variables in memory.
+///
+/// Memory is made of objects: global variables, local arrays and the memory
+/// allocated by each call to `alloc`. A global or local array always refers
+/// to its own object, and an array parameter refers to any of the objects
+/// bound to it in the call sites of its function (transitively through
+/// parameters passed along). Parameters of functions that are never called
+/// may refer to any object.
+///
+/// Scalar local variables and parameters are never in memory, as far as
+/// this analysis is concerned, since there is no way to take their address.
+///
+/// The analysis is flow and context insensitive, so a local array of a
+/// recursive function is the same object in every activation, and so is
+/// the memory allocated by a call evaluated many times.
+///
+/// Functions with the pure attribute are taken at their word, so calling
+/// them never modifies memory. This matters to recursive functions writing
+/// into local arrays of their own activation.
+class AliasAnalysis
+{
+public:
+    explicit AliasAnalysis(ASTProgram& program);
+
+    /// \returns whether two array variables may share memory.
+    bool may_alias(const ASTVarDecl& lhs, const ASTVarDecl& rhs) const;
+
+    /// \returns how evaluating a call may access the memory of a variable,
+    /// including through any function called by the callee.
+    auto get_mod_ref(ASTFunCall& call, const ASTVarDecl& var) const -> ModRef;
+
+    /// \returns how executing a function may access the memory of a
+    /// variable, including through any function called by it.
+    auto get_mod_ref(const ASTFunDecl& fun, const ASTVarDecl& var) const -> ModRef;
+
+    /// \returns whether a variable is declared at the top level.
+    bool is_global(const ASTVarDecl& var) const
+    {
+        return globals.count(&var) != 0;
+    }
+
+public:
+    /// A set of memory objects, by their index in `objects`.
+    class ObjectSet
+    {
+    public:
+        bool contains(size_t object) const
+        {
+            return object < bits.size() && bits[object];
+        }
+
+        bool intersects(const ObjectSet& other) const;
+
+        void insert(size_t object);
+
+        /// Inserts every object of `other` into this set.
+        ///
+        /// \returns whether this set changed.
+        bool merge(const ObjectSet& other);
+
+    private:
+        std::vector<bool> bits;
+    };
+
+private:
+    /// \returns the objects a variable may refer to, which is empty for
+    /// variables not in memory.
+    auto points_to(const ASTVarDecl& var) const -> const ObjectSet&;
+
+    /// \returns the objects an expression of array type may refer to.
+    auto points_to(ASTExpr& array) const -> const ObjectSet&;
+
+private:
+    struct FunSummary
+    {
+        ObjectSet mod;
+        ObjectSet ref;
+    };
+
+    std::unordered_set<const ASTVarDecl*> globals;
+    std::vector<const ASTVarDecl*> objects;
+    std::unordered_map<const ASTVarDecl*, ObjectSet> var_points_to;
+    std::unordered_map<const ASTFunCall*, ObjectSet> call_points_to;
+    std::unordered_map<const ASTFunDecl*, FunSummary> summaries;
+    ObjectSet empty_set;
+};
+}
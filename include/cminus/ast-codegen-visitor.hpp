@@ -1,8 +1,36 @@
 #pragma once
 #include <cminus/ast-visitor.hpp>
+#include <cminus/compilation-budget.hpp>
+#include <cminus/constant-propagation.hpp>
+#include <cminus/global-promotion.hpp>
+#include <cminus/row-hoisting.hpp>
+#include <cminus/scalar-replacement.hpp>
+#include <optional>
+#include <vector>
 
 namespace cminus
 {
+/// Options controlling the code generator.
+struct CodegenOptions
+{
+    /// Whether to optimize the generated code.
+    bool optimize = false;
+
+    /// Whether to keep a chain of frame pointers in `$fp`, so the stack can
+    /// be unwound (e.g. by profilers).
+    ///
+    /// Each frame pointer points to the saved block of its stack frame,
+    /// which holds the return address followed by the caller's `$fp`.
+    bool frame_pointer = false;
+
+    /// Whether to count the calls between each pair of functions.
+    ///
+    /// Every prologue calls `__crt_mcount`, and `main` calls
+    /// `__crt_mcleanup` before returning so the counts are written out.
+    /// The code generator emits the tables these runtime routines use.
+    bool profile = false;
+};
+
 /// This is a code generator for MIPS.
 ///
 /// The generated code is fully compatible with the O32 ABI, thus functions
@@ -10,13 +38,15 @@ namespace cminus
 ///
 /// This generator does no perform register allocation, therefore the
 /// spit code makes very poor use of registers. Indeed, it makes poor
-/// use of everything as there is no optimization whatsover.
+/// use of everything as there is little optimization, only when asked for.
 ///
 class ASTCodegenVisitor : public ASTVisitor
 {
 public:
-    explicit ASTCodegenVisitor(std::string& dest) :
-        dest(dest)
+    explicit ASTCodegenVisitor(std::string& dest,
+                               CodegenOptions options = CodegenOptions()) :
+        dest(dest),
+        options(options)
     {
     }
 
@@ -36,11 +66,54 @@ public:
     void visit_var_expr(ASTVarRef& expr) override;
     void visit_call_expr(ASTFunCall& expr) override;
     void visit_binary_expr(ASTBinaryExpr& expr) override;
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override;
 
     void visit_type(ExprType type) override;
     void visit_name(SourceRange name) override;
 
 public:
+    /// Associates a range of generated lines with the source it came from.
+    ///
+    /// The range begins at `asm_line` and ends right before the `asm_line`
+    /// of the next entry. An entry without a function ends the last range.
+    struct LineMapEntry
+    {
+        uint32_t asm_line; //< one-based line in the generated code
+        SourceLocation loc;
+        ASTFunDecl* fun;
+    };
+
+    /// Records a line map of the code generated from now on into `line_map`.
+    void record_line_map(std::vector<LineMapEntry>& line_map)
+    {
+        this->line_map = &line_map;
+    }
+
+    /// Checks the code generated from now on against `budget`, stopping
+    /// the generation once it is exhausted. The code is left incomplete.
+    void set_budget(CompilationBudget& budget)
+    {
+        this->budget = &budget;
+    }
+
+    /// A location in the stack frame of a function, relative to the block
+    /// it belongs to.
+    struct FrameSlot
+    {
+        enum Block : uint8_t
+        {
+            Output,
+            Temp,
+            Saved,
+            Local,
+            Input,
+            End, //< the end of the frame, i.e. its size
+        };
+
+        Block block;
+        int32_t offset;
+    };
+
     struct FrameInfo
     {
         // $sp => | output | temp | saved | local | input |
@@ -57,26 +130,124 @@ public:
         int32_t saved_offset(int32_t offset) const;
         int32_t local_offset(int32_t offset) const;
         int32_t input_offset(int32_t offset) const;
+
+        /// \returns the offset of a slot from the base of the frame.
+        int32_t offset_of(FrameSlot slot) const;
     };
 
+    /// \returns the stack frame of each function generated so far.
+    auto get_frames() const -> const std::unordered_map<ASTFunDecl*, FrameInfo>&
+    {
+        return frames;
+    }
+
 private:
+    /// Records that the code generated from now on comes from `loc`.
+    void mark_source(SourceLocation loc);
+
+    /// Records that the code generated from now on comes from `expr`.
+    void mark_source(const ASTExpr& expr);
+
+    /// \returns the constant value of an expression, if it is known to be
+    /// constant by the optimizer.
+    auto get_constant(const ASTExpr& expr) const -> std::optional<int32_t>;
+
+    /// \returns whether a statement is known to be never executed.
+    bool is_unreachable(const ASTStmt& stmt) const;
+
+    /// \returns how to perform an access to an array element.
+    auto get_element_access(const ASTExpr& expr) const -> ElementAccess;
+
+    /// \returns the register a global scalar is kept in by the loops being
+    /// generated, or -1 if it is in memory.
+    int get_promoted_reg(const ASTVarDecl& var) const;
+
+    /// Stores the promoted globals modified by the loops being generated
+    /// back into memory.
+    void emit_promoted_stores(size_t outer_size);
+
+    /// Emits a copy between registers.
+    void emit_move(int dest_reg, int source_reg);
+
+    /// Loads a constant into $v0.
+    void emit_load_constant(int32_t value);
+
+    /// Computes `$v0 = $t0 op $v0`, or stores $v0 at the address in $t0 for
+    /// assignments.
+    void emit_binary_operation(ASTBinaryExpr::Operation op);
+
+    /// \returns how many statements at the beginning of a function body are
+    /// early returns which need no stack frame, i.e. `if(c) return e;` with
+    /// `c` and `e` computable in registers. They are only looked for when
+    /// optimizing.
+    size_t count_frameless_guards(ASTFunDecl& decl);
+
+    /// \returns whether an expression is computable without calls nor
+    /// stack frame, before the prologue of the current function.
+    bool is_frameless(ASTExpr& expr);
+
+    /// Loads a frameless expression into $v0.
+    void emit_frameless_expr(ASTExpr& expr);
+
+    /// Emits an early return which needs no stack frame, before the
+    /// prologue.
+    void emit_frameless_guard(ASTSelectionStmt& if_stmt);
+
+    /// Emits the statements laid out after the epilogue of the current
+    /// function, since they are rarely executed.
+    void emit_cold_blocks();
+
+    /// \returns the register a parameter of the current function arrives
+    /// in, or -1 if it arrives in memory or `var` is not a parameter.
+    int get_param_reg(const ASTVarDecl& var) const;
+
+    /// \returns the constant a compound assignment adds to its variable, if
+    /// it is known and small enough for an immediate.
+    auto get_constant_step(ASTCompoundAssignExpr& expr) const -> std::optional<int32_t>;
+
+    /// \returns the functions of the program in the order their code is
+    /// laid out.
+    auto layout_functions(ASTProgram& program) -> std::vector<ASTFunDecl*>;
+
+    /// Emits the tables used by the profiling runtime, given the functions
+    /// in the order they are laid out.
+    void emit_profile_tables(const std::vector<ASTFunDecl*>& funs);
+
     /// Loads the address of the variable into $v0.
     void load_address_of(ASTVarRef&);
 
+    /// Loads the address of the first element of an array into $v0.
+    void load_base_address(ASTVarDecl& var_decl);
+
+    /// Adds to the address in $v0 the subscript `index` times `stride`
+    /// bytes, going out of bounds if the subscript is negative.
+    void emit_add_index(ASTExpr& index, int32_t stride);
+
+    /// Multiplies $v0 by a positive constant, with shifts and adds when
+    /// that is cheaper than a multiplication.
+    void emit_scale(int32_t factor);
+
+    /// Emits the offset of a slot from the base of the current stack frame.
+    ///
+    /// The frame grows while its function is generated, thus the offset is
+    /// only filled in by `patch_frame_offsets`.
+    void emit_frame_offset(FrameSlot slot);
+
+    /// Fills in the offsets emitted by `emit_frame_offset` in the function
+    /// starting at `function_begin`, now that its frame is complete.
+    void patch_frame_offsets();
+
     /// Emits a store word into the current stack frame.
-    void emit_frame_sw(int reg, int32_t frame_offset);
+    void emit_frame_sw(int reg, FrameSlot slot);
 
     /// Emits a load word from the current stack frame.
-    void emit_frame_lw(int reg, int32_t frame_offset);
+    void emit_frame_lw(int reg, FrameSlot slot);
 
     /// Allocates temporary space in the stack frame.
-    ///
-    /// This size must have been calculated by `FrameAllocator`. Otherwise,
-    /// bad things may happen.
-    int32_t temp_alloc(int32_t size);
+    auto temp_alloc(int32_t size) -> FrameSlot;
 
     /// Frees temporary space from the stack frame.
-    void temp_free(int32_t offset, int32_t size);
+    void temp_free(FrameSlot slot, int32_t size);
 
     /// Generates a label id.
     int32_t next_label_id();
@@ -86,14 +257,72 @@ private:
 
 private:
     std::string& dest;
+    CodegenOptions options;
     std::unordered_map<ASTFunDecl*, FrameInfo> frames;
-    std::unordered_map<ASTVarDecl*, int32_t> local_pos;
+    std::unordered_map<ASTVarDecl*, FrameSlot> local_pos;
+
+    /// An offset to fill in once the frame of the function is complete.
+    struct FrameFixup
+    {
+        size_t pos; //< where the offset goes in `dest`
+        FrameSlot slot;
+    };
 
     FrameInfo current_frame;
+    std::vector<FrameFixup> frame_fixups;
+    size_t function_begin = 0; //< position of the current function in `dest`
+    int32_t current_local_pos = 0;
     int32_t current_temp_pos = 0;
     int32_t current_label_id = 0;
     bool inside_function = false;
     int32_t function_label_goto_ob = -1;
     int32_t function_epilogue_label;
+    size_t num_frameless_guards = 0; //< emitted before the prologue
+    uint32_t function_index = 0; //< position among the functions of the program
+
+    /// Constants in the current function, only when optimizing.
+    std::optional<ConstantPropagation> constants;
+
+    /// Array elements kept in registers in the current function, only
+    /// when optimizing.
+    std::optional<ScalarReplacement> elements;
+
+    /// Alias analysis of the program, only when optimizing.
+    std::optional<AliasAnalysis> aliases;
+
+    /// Global scalars kept in registers in the current function, only when
+    /// optimizing.
+    std::optional<GlobalPromotion> promotions;
+
+    /// The globals promoted by the loops being generated, innermost last.
+    std::vector<PromotedGlobal> active_promotions;
+
+    /// Rows of two-dimensional arrays hoisted out of the loops of the
+    /// current function, only when optimizing.
+    std::optional<RowHoisting> rows;
+
+    /// Where the rows hoisted by the loops being generated are kept.
+    std::unordered_map<int, FrameSlot> row_slots;
+
+    /// A statement whose code is laid out after the epilogue of its
+    /// function, along with what is needed to generate it there.
+    struct ColdBlock
+    {
+        ASTStmt* stmt;
+        int32_t label;      //< where the code begins
+        int32_t join_label; //< where the code goes back to
+        std::vector<PromotedGlobal> active_promotions;
+        int32_t local_pos;
+    };
+
+    /// The cold blocks of the current function, only when optimizing.
+    std::vector<ColdBlock> cold_blocks;
+
+    const ASTSourceTable* source_table = nullptr;
+    ASTFunDecl* current_fun = nullptr;
+    std::vector<LineMapEntry>* line_map = nullptr;
+    CompilationBudget* budget = nullptr;
+    size_t line_map_offset = 0; //< position of `line_map_line` in `dest`
+    uint32_t line_map_line = 1;
 };
 }
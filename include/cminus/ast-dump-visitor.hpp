@@ -27,6 +27,7 @@ public:
     void visit_var_expr(ASTVarRef& expr) override;
     void visit_call_expr(ASTFunCall& expr) override;
     void visit_binary_expr(ASTBinaryExpr& expr) override;
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override;
 
     void visit_type(ExprType type) override;
     void visit_name(SourceRange name) override;
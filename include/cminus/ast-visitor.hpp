@@ -34,6 +34,7 @@ public:
     virtual void visit_var_expr(ASTVarRef& expr) { walk_var_expr(expr); }
     virtual void visit_call_expr(ASTFunCall& expr) { walk_call_expr(expr); }
     virtual void visit_binary_expr(ASTBinaryExpr& expr) { walk_binary_expr(expr); }
+    virtual void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) { walk_compound_assign_expr(expr); }
 
     virtual void visit_type(ExprType type) { walk_type(type); }
     virtual void visit_name(SourceRange name) { walk_name(name); }
@@ -69,6 +70,7 @@ public:
     void walk_var_expr(ASTVarRef& expr);
     void walk_call_expr(ASTFunCall& expr);
     void walk_binary_expr(ASTBinaryExpr& expr);
+    void walk_compound_assign_expr(ASTCompoundAssignExpr& expr);
 
     void walk_type(ExprType);
     void walk_name(SourceRange);
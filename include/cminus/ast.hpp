@@ -1,6 +1,10 @@
 #pragma once
 #include <cminus/scanner.hpp>
+#include <cstdint>
 #include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace cminus
 {
@@ -16,6 +20,7 @@ class ASTVarRef;
 class ASTFunCall;
 class ASTBinaryExpr;
 class ASTAssignExpr;
+class ASTCompoundAssignExpr;
 class ASTNullStmt;
 class ASTCompoundStmt;
 class ASTSelectionStmt;
@@ -57,6 +62,107 @@ enum class ExprKind
     FunCall,
     BinaryExpr,
     AssignExpr,
+    CompoundAssignExpr,
+};
+
+/// Attributes of a function, given by the programmer to steer the optimizer.
+enum class FunAttributes : uint8_t
+{
+    None = 0,
+
+    /// The function is executed often.
+    Hot = (1 << 0),
+
+    /// The function is executed rarely.
+    Cold = (1 << 1),
+
+    /// The function must not be inlined into its callers.
+    NoInline = (1 << 2),
+
+    /// The function should be inlined into its callers whenever possible.
+    AlwaysInline = (1 << 3),
+
+    /// The function modifies no memory, thus calls to it only compute
+    /// their result. This is trusted rather than checked.
+    Pure = (1 << 4),
+};
+
+constexpr FunAttributes operator|(FunAttributes lhs, FunAttributes rhs)
+{
+    return static_cast<FunAttributes>(
+            static_cast<uint8_t>(lhs) | static_cast<uint8_t>(rhs));
+}
+
+constexpr FunAttributes operator&(FunAttributes lhs, FunAttributes rhs)
+{
+    return static_cast<FunAttributes>(
+            static_cast<uint8_t>(lhs) & static_cast<uint8_t>(rhs));
+}
+
+constexpr bool operator!(FunAttributes value)
+{
+    return !(static_cast<uint8_t>(value));
+}
+
+/// The name of each function attribute, as written in the source.
+constexpr std::pair<std::string_view, FunAttributes> fun_attribute_names[] = {
+    {"hot", FunAttributes::Hot},
+    {"cold", FunAttributes::Cold},
+    {"noinline", FunAttributes::NoInline},
+    {"alwaysinline", FunAttributes::AlwaysInline},
+    {"pure", FunAttributes::Pure},
+};
+
+/// \returns the function attribute with the given name, or
+/// `FunAttributes::None` if there is no such attribute.
+constexpr auto find_fun_attribute(std::string_view name) -> FunAttributes
+{
+    for(const auto& attr : fun_attribute_names)
+    {
+        if(attr.first == name)
+            return attr.second;
+    }
+    return FunAttributes::None;
+}
+
+/// \returns whether a set of function attributes contradicts itself.
+constexpr bool are_conflicting(FunAttributes attrs)
+{
+    constexpr auto hot_cold = FunAttributes::Hot | FunAttributes::Cold;
+    constexpr auto inlining = FunAttributes::NoInline | FunAttributes::AlwaysInline;
+    return (attrs & hot_cold) == hot_cold || (attrs & inlining) == inlining;
+}
+
+/// Identifier of an expression node.
+///
+/// Data that is rarely needed (e.g. only by diagnostics) is kept in side
+/// tables indexed by this identifier instead of in the node itself, such that
+/// the nodes traversed by code generation stay small.
+using ASTNodeId = uint32_t;
+
+/// Side table with the source range of each expression node.
+class ASTSourceTable
+{
+public:
+    /// Registers the source range of a new expression node.
+    ///
+    /// \returns the identifier for the new node.
+    auto add(SourceRange range) -> ASTNodeId;
+
+    /// \returns the source range of an expression.
+    auto source_range(const ASTExpr& expr) const -> SourceRange;
+
+    /// \returns the starting location of an expression.
+    auto location(const ASTExpr& expr) const -> SourceLocation
+    {
+        return source_range(expr).begin();
+    }
+
+    /// \returns the number of registered nodes.
+    auto size() const -> size_t { return ranges.size(); }
+
+private:
+    std::vector<SourceRange> ranges;
 };
 
 /// Base of any declaration node.
@@ -145,8 +251,16 @@ protected:
 class ASTExpr : public ASTStmt
 {
 public:
+    explicit ASTExpr(ASTNodeId id) :
+        id(id)
+    {
+    }
+
     virtual ~ASTExpr() {}
 
+    /// \returns the identifier of this node in side tables.
+    auto node_id() const -> ASTNodeId { return id; }
+
     virtual auto expr_kind() const -> ExprKind = 0;
 
     virtual auto as_number_expr() -> std::shared_ptr<ASTNumber>
@@ -169,15 +283,13 @@ public:
         return nullptr;
     }
 
-    virtual auto type() const -> ExprType = 0;
-
-    virtual auto source_range() const -> SourceRange = 0;
-
-    auto location() const -> SourceLocation
+    virtual auto as_compound_assign_expr() -> std::shared_ptr<ASTCompoundAssignExpr>
     {
-        return source_range().begin();
+        return nullptr;
     }
 
+    virtual auto type() const -> ExprType = 0;
+
     auto stmt_kind() const -> StmtKind override
     {
         return StmtKind::ExprStmt;
@@ -187,13 +299,17 @@ public:
     {
         return this->cast<ASTExpr>();
     }
+
+protected:
+    ASTNodeId id;
 };
 
 /// Node that represents an entire program.
 class ASTProgram : std::enable_shared_from_this<ASTProgram>
 {
 public:
-    explicit ASTProgram()
+    explicit ASTProgram(std::shared_ptr<const ASTSourceTable> source_table) :
+        source_table(std::move(source_table))
     {
     }
 
@@ -206,8 +322,15 @@ public:
         decls.push_back(std::move(decl));
     }
 
+    /// \returns the source ranges of the expressions in this program.
+    auto get_source_table() const -> const ASTSourceTable&
+    {
+        return *source_table;
+    }
+
 private:
     std::vector<std::shared_ptr<ASTDecl>> decls;
+    std::shared_ptr<const ASTSourceTable> source_table;
 };
 
 // Node that represents a variable declaration.
@@ -227,6 +350,16 @@ public:
     {
     }
 
+    /// Declares a two-dimensional array, whose rows are laid out one after
+    /// the other.
+    explicit ASTVarDecl(SourceRange name,
+                        std::shared_ptr<ASTNumber> array_size,
+                        std::shared_ptr<ASTNumber> array_cols) :
+        ASTVarDecl(name, true, std::move(array_size))
+    {
+        this->array_cols = std::move(array_cols);
+    }
+
     auto decl_kind() const -> DeclKind override
     {
         return DeclKind::VarDecl;
@@ -248,12 +381,32 @@ public:
 
     auto get_array_size() const -> std::shared_ptr<ASTNumber> { return array_size; }
 
+    /// \returns the number of columns of a two-dimensional array or `nullptr`.
+    auto get_array_cols() const -> std::shared_ptr<ASTNumber> { return array_cols; }
+
     bool is_pointer() const { return is_array() && !get_array_size(); }
 
+    bool is_matrix() const { return !!array_cols; }
+
+    /// \returns the number of integers stored by this variable.
+    auto get_num_elements() const -> int64_t;
+
+    /// \returns the number of bytes taken by this variable.
+    auto get_num_bytes() const -> int64_t { return 4 * get_num_elements(); }
+
+    /// \returns the number of bytes between consecutive rows of a
+    /// two-dimensional array, or between consecutive elements otherwise.
+    auto get_row_bytes() const -> int64_t;
+
+    /// The largest number of bytes a variable may take, so that offsets into
+    /// it fit a word of the target.
+    static constexpr int64_t max_bytes = INT32_MAX;
+
 protected:
     SourceRange name;
     std::shared_ptr<ASTNumber> array_size; //< may be null, even if is_array_=true
                                            //< e.g. for function params which are array
+    std::shared_ptr<ASTNumber> array_cols; //< null unless two-dimensional
     bool is_array_;
 };
 
@@ -282,8 +435,14 @@ class ASTFunDecl : public ASTDecl
 {
 public:
     explicit ASTFunDecl(bool is_void_retn, SourceRange name) :
+        ASTFunDecl(is_void_retn ? ExprType::Void : ExprType::Int, name)
+    {
+    }
+
+    /// Only builtins may return arrays, such as `alloc`.
+    explicit ASTFunDecl(ExprType retn_type, SourceRange name) :
         name(name),
-        is_void_retn(is_void_retn)
+        retn_type(retn_type)
     {
     }
 
@@ -302,9 +461,9 @@ public:
 
     SourceRange get_name() const { return name; }
 
-    auto type() const { return is_void() ? ExprType::Void : ExprType::Int; }
+    auto type() const { return this->retn_type; }
 
-    bool is_void() const { return this->is_void_retn; }
+    bool is_void() const { return this->retn_type == ExprType::Void; }
 
     size_t get_num_params() const { return this->params.size(); }
 
@@ -329,19 +488,29 @@ public:
         this->params.push_back(std::move(parm));
     }
 
+    void add_attributes(FunAttributes attrs)
+    {
+        this->attributes = attributes | attrs;
+    }
+
+    auto get_attributes() const -> FunAttributes { return attributes; }
+
+    bool has_attribute(FunAttributes attr) const { return !!(attributes & attr); }
+
 private:
     std::shared_ptr<ASTCompoundStmt> comp_stmt; //< may be null
     std::vector<std::shared_ptr<ASTParmVarDecl>> params;
     SourceRange name;
-    bool is_void_retn;
+    ExprType retn_type;
+    FunAttributes attributes = FunAttributes::None;
 };
 
 /// Node of a number.
 class ASTNumber : public ASTExpr
 {
 public:
-    explicit ASTNumber(int32_t number, SourceRange lexeme) :
-        loc(lexeme), value(number)
+    explicit ASTNumber(int32_t number, ASTNodeId id) :
+        ASTExpr(id), value(number)
     {
     }
 
@@ -362,13 +531,7 @@ public:
         return ExprType::Int;
     }
 
-    auto source_range() const -> SourceRange override
-    {
-        return loc;
-    }
-
 private:
-    SourceRange loc;
     int32_t value;
 };
 
@@ -378,17 +541,29 @@ class ASTVarRef : public ASTExpr
 public:
     explicit ASTVarRef(std::shared_ptr<ASTVarDecl> decl,
                        std::shared_ptr<ASTExpr> expr,
-                       SourceRange loc) :
+                       ASTNodeId id) :
+        ASTExpr(id),
         decl(std::move(decl)),
-        expr(std::move(expr)),
-        loc(loc)
+        expr(std::move(expr))
+    {
+    }
+
+    explicit ASTVarRef(std::shared_ptr<ASTVarDecl> decl,
+                       std::shared_ptr<ASTExpr> expr,
+                       std::shared_ptr<ASTExpr> col_expr,
+                       ASTNodeId id) :
+        ASTVarRef(std::move(decl), std::move(expr), id)
     {
+        this->col_expr = std::move(col_expr);
     }
 
+    /// A two-dimensional array subscripted once is one of its rows.
     auto type() const -> ExprType override
     {
-        if(expr)
+        if(col_expr)
             return ExprType::Int;
+        else if(expr)
+            return this->decl->is_matrix() ? ExprType::Array : ExprType::Int;
         else if(this->decl->is_array())
             return ExprType::Array;
         else
@@ -401,11 +576,19 @@ public:
     }
 
     /// \returns the subscript expression or `nullptr` if none.
+    ///
+    /// This is the row of a two-dimensional array.
     auto get_index() -> std::shared_ptr<ASTExpr>
     {
         return expr;
     }
 
+    /// \returns the column subscript of a two-dimensional array or `nullptr`.
+    auto get_col_index() -> std::shared_ptr<ASTExpr>
+    {
+        return col_expr;
+    }
+
     auto expr_kind() const -> ExprKind override
     {
         return ExprKind::VarRef;
@@ -416,15 +599,10 @@ public:
         return this->cast<ASTVarRef>();
     }
 
-    auto source_range() const -> SourceRange override
-    {
-        return loc;
-    }
-
 private:
     std::shared_ptr<ASTVarDecl> decl;
-    std::shared_ptr<ASTExpr> expr; //< subscript expression, may be null
-    SourceRange loc;
+    std::shared_ptr<ASTExpr> expr;     //< subscript expression, may be null
+    std::shared_ptr<ASTExpr> col_expr; //< column subscript expression, may be null
 };
 
 /// Node of a function call in the AST.
@@ -433,10 +611,10 @@ class ASTFunCall : public ASTExpr
 public:
     explicit ASTFunCall(std::shared_ptr<ASTFunDecl> decl,
                         std::vector<std::shared_ptr<ASTExpr>> args,
-                        SourceRange loc) :
+                        ASTNodeId id) :
+        ASTExpr(id),
         decl(std::move(decl)),
-        args(std::move(args)),
-        loc(loc)
+        args(std::move(args))
     {
     }
 
@@ -445,10 +623,7 @@ public:
 
     auto type() const -> ExprType override
     {
-        if(this->decl->is_void())
-            return ExprType::Void;
-        else
-            return ExprType::Int;
+        return this->decl->type();
     }
 
     auto get_decl() -> std::shared_ptr<ASTFunDecl>
@@ -466,15 +641,9 @@ public:
         return this->cast<ASTFunCall>();
     }
 
-    auto source_range() const -> SourceRange override
-    {
-        return loc;
-    }
-
 private:
     std::shared_ptr<ASTFunDecl> decl;
     std::vector<std::shared_ptr<ASTExpr>> args;
-    SourceRange loc;
 };
 
 /// Node of a binary expression in the AST.
@@ -499,9 +668,10 @@ public:
 public:
     explicit ASTBinaryExpr(std::shared_ptr<ASTExpr> left,
                            std::shared_ptr<ASTExpr> right,
-                           Operation op) :
-        left(std::move(left)),
-        right(std::move(right)), op(op)
+                           Operation op,
+                           ASTNodeId id) :
+        ASTExpr(id),
+        op(op), left(std::move(left)), right(std::move(right))
     {
         assert(this->left != nullptr && this->right != nullptr);
     }
@@ -525,20 +695,13 @@ public:
         return this->cast<ASTBinaryExpr>();
     }
 
-    auto source_range() const -> SourceRange override
-    {
-        auto left_loc = left->source_range().begin();
-        auto right_loc = right->source_range().end();
-        return SourceRange(left_loc, std::distance(left_loc, right_loc));
-    }
-
     /// Converts an word category into a operation enumeration.
     static Operation type_from_category(Category category);
 
 private:
+    Operation op; //< first so it fits in the padding of the base
     std::shared_ptr<ASTExpr> left;
     std::shared_ptr<ASTExpr> right;
-    Operation op;
 };
 
 /// Node of an assignment expression.
@@ -546,8 +709,9 @@ class ASTAssignExpr : public ASTBinaryExpr
 {
 public:
     explicit ASTAssignExpr(std::shared_ptr<ASTVarRef> left,
-                           std::shared_ptr<ASTExpr> right) :
-        ASTBinaryExpr(std::move(left), std::move(right), Operation::Assign)
+                           std::shared_ptr<ASTExpr> right,
+                           ASTNodeId id) :
+        ASTBinaryExpr(std::move(left), std::move(right), Operation::Assign, id)
     {
     }
 
@@ -557,6 +721,76 @@ public:
     }
 };
 
+/// Node of an assignment which also reads the variable assigned, i.e. a
+/// compound assignment (`x += e`) or an increment (`++x`, `x--`).
+///
+/// The variable is read after the right hand side is evaluated, and the
+/// address of an element is only computed once.
+class ASTCompoundAssignExpr : public ASTExpr
+{
+public:
+    /// How the expression is written, which decides its value.
+    enum class Form : uint8_t
+    {
+        Compound, //< `x op= e`, evaluates to the new value
+        Prefix,   //< `++x` or `--x`, evaluates to the new value
+        Postfix,  //< `x++` or `x--`, evaluates to the old value
+    };
+
+    using Operation = ASTBinaryExpr::Operation;
+
+public:
+    explicit ASTCompoundAssignExpr(std::shared_ptr<ASTVarRef> var,
+                                   std::shared_ptr<ASTExpr> right,
+                                   Operation op,
+                                   Form form,
+                                   ASTNodeId id) :
+        ASTExpr(id),
+        op(op), form(form), var(std::move(var)), right(std::move(right))
+    {
+        assert(this->var != nullptr && this->right != nullptr);
+        assert(op == Operation::Plus || op == Operation::Minus
+               || op == Operation::Multiply || op == Operation::Divide);
+    }
+
+    auto type() const -> ExprType override
+    {
+        return ExprType::Int;
+    }
+
+    auto get_var() -> std::shared_ptr<ASTVarRef> { return var; }
+
+    /// \returns the right hand side, which is the number one for increments.
+    auto get_right() -> std::shared_ptr<ASTExpr> { return right; }
+
+    auto get_operation() const -> Operation { return op; }
+    auto get_form() const -> Form { return form; }
+
+    /// \returns whether the expression evaluates to the value the variable
+    /// had before the assignment.
+    bool yields_old_value() const { return form == Form::Postfix; }
+
+    auto expr_kind() const -> ExprKind override
+    {
+        return ExprKind::CompoundAssignExpr;
+    }
+
+    auto as_compound_assign_expr() -> std::shared_ptr<ASTCompoundAssignExpr> override
+    {
+        return this->cast<ASTCompoundAssignExpr>();
+    }
+
+    /// Converts the category of a compound assignment or increment operator
+    /// into the operation it performs.
+    static Operation type_from_category(Category category);
+
+private:
+    Operation op;
+    Form form;
+    std::shared_ptr<ASTVarRef> var;
+    std::shared_ptr<ASTExpr> right;
+};
+
 /// Node for an empty statement in the AST.
 class ASTNullStmt : public ASTStmt
 {
@@ -0,0 +1,70 @@
+#pragma once
+#include <cminus/ast.hpp>
+#include <vector>
+
+namespace cminus
+{
+/// Index of a basic block in a control flow graph.
+using CFGBlockId = uint32_t;
+
+/// A sequence of full expressions always evaluated one after the other.
+struct CFGBlock
+{
+    enum Terminator
+    {
+        Goto,   //< continues at the only successor
+        Branch, //< continues at the first successor if `cond` is non-zero,
+                //< or at the second one otherwise
+        Exit,   //< leaves the function, has no successors
+    };
+
+    /// Full expressions evaluated in this block, in order.
+    std::vector<ASTExpr*> exprs;
+
+    Terminator terminator = Goto;
+
+    /// The controlling expression of a `Branch`, evaluated after `exprs`.
+    ASTExpr* cond = nullptr;
+
+    /// The statement that ends this block, if any (i.e. an if, while or
+    /// return statement).
+    ASTStmt* stmt = nullptr;
+
+    std::vector<CFGBlockId> succs;
+    std::vector<CFGBlockId> preds;
+};
+
+/// The control flow graph of a function definition.
+///
+/// Blocks reference the nodes of the abstract syntax tree, thus the graph
+/// must not outlive the tree it was built from.
+class CFG
+{
+public:
+    /// Builds the control flow graph of a function definition.
+    static auto build(ASTFunDecl& decl) -> CFG;
+
+    /// \returns the block where the function begins.
+    auto entry() const -> CFGBlockId { return 0; }
+
+    /// \returns the block every return statement continues to.
+    auto exit() const -> CFGBlockId { return 1; }
+
+    auto size() const -> size_t { return blocks.size(); }
+
+    auto block(CFGBlockId id) -> CFGBlock& { return blocks[id]; }
+    auto block(CFGBlockId id) const -> const CFGBlock& { return blocks[id]; }
+
+    auto begin() const { return blocks.begin(); }
+    auto end() const { return blocks.end(); }
+
+    /// Adds an empty block to the graph.
+    auto add_block() -> CFGBlockId;
+
+    /// Adds an edge between two blocks.
+    void add_edge(CFGBlockId from, CFGBlockId to);
+
+private:
+    std::vector<CFGBlock> blocks;
+};
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cminus
+{
+/// The resources a single compilation may use. Zero means no limit.
+struct CompilationLimits
+{
+    /// The maximum wall time, in milliseconds.
+    uint64_t max_time_ms = 0;
+
+    /// The maximum amount of memory, in bytes, taken by the source and the
+    /// nodes of its AST.
+    uint64_t max_memory = 0;
+
+    /// The maximum number of AST nodes.
+    uint64_t max_ast_nodes = 0;
+
+    /// The maximum size of the generated code, in bytes.
+    uint64_t max_output = 0;
+};
+
+/// Why a compilation ran out of budget.
+enum class BudgetReason : uint8_t
+{
+    None,
+    Time,
+    Memory,
+    AstNodes,
+    Output,
+    Cancelled, //< cancelled by someone else
+};
+
+/// Accounts the resources spent by a compilation against its limits.
+///
+/// The budget is cooperative. The scanner, the parser and the code generator
+/// poll it at cheap points and wind down once it is exhausted, which makes
+/// the parser report `Diag::budget_exhausted`. Other threads may cancel the
+/// compilation at any time, which exhausts the budget as well.
+class CompilationBudget
+{
+public:
+    explicit CompilationBudget(const CompilationLimits& limits) :
+        limits(limits),
+        start(std::chrono::steady_clock::now())
+    {
+    }
+
+    CompilationBudget(const CompilationBudget&) = delete;
+    CompilationBudget& operator=(const CompilationBudget&) = delete;
+
+    /// Exhausts the budget. This may be called from any thread.
+    void cancel() { exhaust(BudgetReason::Cancelled); }
+
+    /// \returns whether the budget is exhausted.
+    bool exhausted() const { return get_reason() != BudgetReason::None; }
+
+    /// \returns why the budget is exhausted, if it is.
+    auto get_reason() const -> BudgetReason
+    {
+        return reason.load(std::memory_order_relaxed);
+    }
+
+    /// Checks the budget at a point of progress of the compilation. The
+    /// clock is only read once in a while, so this is cheap enough to be
+    /// called for every word or statement.
+    ///
+    /// \returns whether the budget is exhausted.
+    bool poll()
+    {
+        if(++polls % time_poll_interval == 0)
+            check_time();
+        return exhausted();
+    }
+
+    /// Charges memory allocated by the compilation.
+    void charge_memory(size_t bytes);
+
+    /// Charges an AST node of the given size.
+    void charge_ast_node(size_t bytes);
+
+    /// Checks the size of the code generated so far.
+    ///
+    /// \returns whether the budget is exhausted.
+    bool check_output(size_t bytes);
+
+    /// Checks the wall time spent so far.
+    void check_time();
+
+    static auto reason_name(BudgetReason reason) -> std::string_view;
+
+private:
+    void exhaust(BudgetReason why);
+
+private:
+    static constexpr uint32_t time_poll_interval = 1024;
+
+    CompilationLimits limits;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<BudgetReason> reason = BudgetReason::None;
+
+    uint32_t polls = 0;
+    uint64_t memory = 0;
+    uint64_t ast_nodes = 0;
+};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cminus/ast-codegen-visitor.hpp>
+#include <cminus/scanner.hpp>
+#include <cminus/semantics.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cminus
+{
+/// Counters describing the shape of a program and of the code generated
+/// from it, as needed to correlate compile time and code quality with it.
+struct CompilationStats
+{
+    ScannerStats scanner;
+    SemaStats sema;
+
+    /// The number of AST nodes of each kind, indexed by the kind.
+    uint32_t decls[static_cast<size_t>(DeclKind::FunDecl) + 1] = {};
+    uint32_t stmts[static_cast<size_t>(StmtKind::ReturnStmt) + 1] = {};
+    uint32_t exprs[static_cast<size_t>(ExprKind::CompoundAssignExpr) + 1] = {};
+
+    /// The stack frame of each function, in program order. The size of the
+    /// temporaries is the high water mark of the temporaries in use.
+    std::vector<std::pair<ASTFunDecl*, ASTCodegenVisitor::FrameInfo>> frames;
+
+    /// The number of instructions generated for each opcode.
+    std::map<std::string, uint32_t, std::less<>> instructions;
+
+    /// The number of labels generated.
+    uint32_t labels = 0;
+};
+
+/// Counts the nodes of the AST of a program into `stats`.
+void collect_ast_stats(ASTProgram& program, CompilationStats& stats);
+
+/// Counts the frames, instructions and labels of the code generated for a
+/// program into `stats`.
+void collect_codegen_stats(
+        ASTProgram& program,
+        const std::unordered_map<ASTFunDecl*, ASTCodegenVisitor::FrameInfo>& frames,
+        std::string_view code,
+        CompilationStats& stats);
+}
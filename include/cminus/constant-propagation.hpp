@@ -0,0 +1,40 @@
+#pragma once
+#include <cminus/cfg.hpp>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace cminus
+{
+/// Conditional constant propagation over a function definition.
+///
+/// The values of scalar local variables and parameters are propagated
+/// through assignments and across branches by a dataflow analysis over the
+/// control flow graph of the function. Only the edges that may be executed
+/// under the constants found so far are followed (as in Wegman and Zadeck's
+/// conditional constant propagation), therefore branches whose conditions
+/// become constant do not spoil the values in the rest of the function.
+///
+/// Global and array variables are never assumed to be constant.
+class ConstantPropagation
+{
+public:
+    explicit ConstantPropagation(ASTFunDecl& decl, const CFG& cfg);
+
+    /// \returns the value of an expression that evaluates to the same
+    /// constant every time it is executed, or nothing if it may not.
+    ///
+    /// Expressions with side effects (assignments and calls), and those
+    /// enclosing them, are never considered constant, though their operands
+    /// may be.
+    auto get_constant(const ASTExpr& expr) const -> std::optional<int32_t>;
+
+    /// \returns whether a statement is an arm of an if or while statement
+    /// that is never executed, because its condition is constant.
+    bool is_unreachable(const ASTStmt& stmt) const;
+
+private:
+    std::unordered_map<const ASTExpr*, int32_t> constants;
+    std::unordered_set<const ASTStmt*> unreachable;
+};
+}
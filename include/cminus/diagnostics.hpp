@@ -23,6 +23,7 @@ enum class Diag
     parser_expected_type,
     parser_expected_expression,
     parser_expected_statement,
+    parser_expected_lvalue,
     parser_number_too_big,
 
     sema_redefinition,          // %0 => SymbolName
@@ -30,6 +31,7 @@ enum class Diag
     sema_empty_program,
     sema_last_decl_not_main,
     sema_var_cannot_be_void,
+    sema_array_too_large,
     sema_assignment_type_error,
     sema_binary_expr_type_error,
     sema_array_statement,
@@ -43,6 +45,10 @@ enum class Diag
     sema_arg_too_few_params,
     sema_arg_too_many_params,
     sema_arg_type_mismatch,
+    sema_unknown_attribute,      // %0 => SymbolName
+    sema_conflicting_attributes, // %0 => SymbolName
+
+    budget_exhausted, // see `CompilationBudget::get_reason`
 };
 
 /// Parameter for `Diag` printing.
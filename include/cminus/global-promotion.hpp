@@ -0,0 +1,45 @@
+#pragma once
+#include <cminus/alias-analysis.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace cminus
+{
+/// A global scalar variable kept in a register throughout a loop.
+struct PromotedGlobal
+{
+    ASTVarDecl* var;
+    uint8_t reg;
+    bool is_modified; //< whether the loop may write into the variable
+};
+
+/// Register promotion of global scalar variables in loops.
+///
+/// A global scalar accessed in a while statement is kept in a register for
+/// the whole statement, provided that no call made by the statement may
+/// access the variable. The variable is loaded before entering the loop and,
+/// if the loop writes into it, stored back on the way out of the loop, which
+/// is either through its exit or a return statement.
+///
+/// The callee-saved registers `$s0`-`$s7` are used, so that promoted
+/// variables survive the calls in the loop. The function must save the ones
+/// it uses.
+class GlobalPromotion
+{
+public:
+    explicit GlobalPromotion(ASTFunDecl& fun, const AliasAnalysis& aliases);
+
+    /// \returns the variables promoted throughout a loop, which are not
+    /// promoted by any enclosing loop.
+    auto get_promoted(const ASTIterationStmt& loop) const
+            -> const std::vector<PromotedGlobal>&;
+
+    /// \returns how many registers, from `$s0` onwards, the function uses.
+    auto get_num_regs() const -> uint8_t { return num_regs; }
+
+private:
+    std::unordered_map<const ASTIterationStmt*, std::vector<PromotedGlobal>> promoted;
+    std::vector<PromotedGlobal> none;
+    uint8_t num_regs = 0;
+};
+}
@@ -0,0 +1,662 @@
+#pragma once
+#include <array>
+#include <cminus/diagnostics.hpp>
+#include <cminus/scanner.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+
+// This is the grammar of the C- language in a form suitable for predictive
+// parsing. The original grammar (found at the very bottom of this file) was
+// left-factored and had its left recursions removed, such that a single word
+// of lookahead is enough to predict every production.
+//
+// The productions are interleaved with semantic action markers, which the
+// parser executes once they reach the top of its stack. The prediction
+// table is computed from the productions at compile time.
+
+namespace cminus
+{
+/// Number of word categories, i.e. terminals of the grammar.
+constexpr size_t num_categories = static_cast<size_t>(Category::Eof) + 1;
+
+/// Nonterminals of the predictive grammar.
+enum class NonTerminal : uint8_t
+{
+    Program,
+    DeclarationList,
+    Declaration,
+    DeclarationRest,
+    VarDeclaration,
+    VarDeclarationRest,
+    ArraySizeRest,
+    TypeSpecifier,
+    Params,
+    ParamsAfterVoid,
+    ParamList,
+    Param,
+    ParamArray,
+    FunBody,
+    AttributeList,
+    CompoundStmt,
+    CompoundRest,
+    LocalDeclarations,
+    StatementList,
+    Statement,
+    ExpressionStmt,
+    SelectionStmt,
+    ElsePart,
+    IterationStmt,
+    ReturnStmt,
+    ReturnValue,
+    Expression,
+    AssignTail,
+    AssignOp,
+    SimpleExpression,
+    RelopTail,
+    Relop,
+    AdditiveExpression,
+    AdditiveTail,
+    Addop,
+    Term,
+    TermTail,
+    Mulop,
+    Factor,
+    FactorRest,
+    IndexRest,
+    PostfixTail,
+    IncrementOp,
+    Args,
+    ArgList,
+    Number,
+};
+
+constexpr size_t num_nonterminals = static_cast<size_t>(NonTerminal::Number) + 1;
+
+/// Semantic actions interleaved with the productions of the grammar.
+///
+/// Each action consumes values from the top of the parser value stack and
+/// pushes its result back. See `SemaActions::run_action` for details.
+enum class ParseAction : uint8_t
+{
+    ProgramStart,
+    ProgramEnd,
+    TopLevelDecl,
+    VarDecl,
+    ArrayVarDecl,
+    MatrixVarDecl,
+    FunDeclStart,
+    FunAttribute,
+    FunDeclBody,
+    FunDeclEnd,
+    ScalarParam,
+    ArrayParam,
+    Discard,
+    EnterParamsScope,
+    EnterFunScope,
+    EnterScope,
+    LeaveScope,
+    CompoundStart,
+    AppendDecl,
+    StatementsStart,
+    AppendStmt,
+    CompoundStmt,
+    NullStmt,
+    ExprStmt,
+    SelectionStmt,
+    SelectionElseStmt,
+    IterationStmt,
+    ReturnStmt,
+    ReturnValueStmt,
+    CheckAssign,
+    Assign,
+    BinaryExpr,
+    Number,
+    Var,
+    IndexedVar,
+    MatrixVar,
+    PreIncrement,
+    PostIncrement,
+    CallStart,
+    AppendArg,
+    Call,
+};
+
+/// A symbol in the right hand side of a production.
+struct GrammarSymbol
+{
+    enum Kind : uint8_t
+    {
+        Terminal,     //< matches a word and discards it
+        TerminalWord, //< matches a word and pushes it into the value stack
+        NonTerminal,
+        Action,
+    };
+
+    Kind kind;
+    uint8_t value;
+
+    constexpr auto category() const -> Category { return static_cast<Category>(value); }
+    constexpr auto nonterminal() const -> cminus::NonTerminal { return static_cast<cminus::NonTerminal>(value); }
+    constexpr auto action() const -> ParseAction { return static_cast<ParseAction>(value); }
+
+    constexpr bool is_terminal() const { return kind == Terminal || kind == TerminalWord; }
+};
+
+/// A production of the grammar.
+struct Production
+{
+    static constexpr size_t max_symbols = 10;
+
+    NonTerminal lhs;
+    std::array<GrammarSymbol, max_symbols> rhs{};
+    uint8_t size = 0;
+
+    constexpr Production(NonTerminal lhs, std::initializer_list<GrammarSymbol> symbols) :
+        lhs(lhs)
+    {
+        for(auto symbol : symbols)
+            this->rhs[size++] = symbol;
+    }
+};
+
+/// What to do once no production of a nonterminal predicts the lookahead.
+struct NonTerminalInfo
+{
+    enum Recovery : uint8_t
+    {
+        /// Reports `diag` (with `expected` as argument if it is a
+        /// `Diag::parser_expected_token`).
+        Report,
+        /// Takes the empty production (or the sole production) of the
+        /// nonterminal, delaying the error until the next terminal mismatch.
+        Fallback,
+    };
+
+    NonTerminal symbol;
+    Recovery recovery;
+    Diag diag = Diag::parser_expected_token;
+    Category expected = Category::Eof;
+    /// Whether conflicts between the empty production and the others are
+    /// resolved in favour of the non-empty ones (e.g. the dangling else).
+    bool greedy = false;
+};
+
+/// Set of terminals, one bit per category.
+using TerminalSet = uint64_t;
+static_assert(num_categories <= 64);
+
+constexpr auto bit(Category c) -> TerminalSet
+{
+    return TerminalSet(1) << static_cast<size_t>(c);
+}
+
+/// The prediction table of a LL(1) grammar.
+struct ParseTable
+{
+    static constexpr uint8_t no_production = 0xFF;
+
+    /// Maps a nonterminal and a lookahead into a production index.
+    std::array<std::array<uint8_t, num_categories>, num_nonterminals> predict{};
+
+    /// Number of problems found while building the table. Must be zero.
+    size_t conflicts = 0;
+};
+
+namespace grammar
+{
+constexpr auto T(Category c) -> GrammarSymbol
+{
+    return {GrammarSymbol::Terminal, static_cast<uint8_t>(c)};
+}
+
+constexpr auto W(Category c) -> GrammarSymbol
+{
+    return {GrammarSymbol::TerminalWord, static_cast<uint8_t>(c)};
+}
+
+constexpr auto N(NonTerminal n) -> GrammarSymbol
+{
+    return {GrammarSymbol::NonTerminal, static_cast<uint8_t>(n)};
+}
+
+constexpr auto A(ParseAction a) -> GrammarSymbol
+{
+    return {GrammarSymbol::Action, static_cast<uint8_t>(a)};
+}
+
+using C = Category;
+using NT = NonTerminal;
+using PA = ParseAction;
+using NI = NonTerminalInfo;
+
+// clang-format off
+constexpr Production productions[] = {
+    // <program> ::= <declaration-list>
+    // <declaration-list> ::= <declaration-list> <declaration> | <declaration>
+    {NT::Program, {A(PA::ProgramStart), N(NT::Declaration), N(NT::DeclarationList), T(C::Eof), A(PA::ProgramEnd)}},
+    {NT::DeclarationList, {N(NT::Declaration), N(NT::DeclarationList)}},
+    {NT::DeclarationList, {}},
+
+    // <declaration> ::= <var-declaration> | <fun-declaration>
+    // <fun-declaration> ::= <type-specifier> ID ( <params> ) <fun-body>
+    {NT::Declaration, {N(NT::TypeSpecifier), W(C::Identifier), N(NT::DeclarationRest)}},
+    {NT::DeclarationRest, {T(C::OpenParen), A(PA::FunDeclStart), A(PA::EnterParamsScope), N(NT::Params),
+                           T(C::CloseParen), N(NT::FunBody), A(PA::FunDeclBody), A(PA::LeaveScope),
+                           A(PA::FunDeclEnd), A(PA::TopLevelDecl)}},
+    {NT::DeclarationRest, {N(NT::VarDeclarationRest), A(PA::TopLevelDecl)}},
+
+    // <var-declaration> ::= <type-specifier> ID ; | <type-specifier> ID [ NUM ] ;
+    //                     | <type-specifier> ID [ NUM ] [ NUM ] ;
+    {NT::VarDeclaration, {N(NT::TypeSpecifier), W(C::Identifier), N(NT::VarDeclarationRest)}},
+    {NT::VarDeclarationRest, {T(C::Semicolon), A(PA::VarDecl)}},
+    {NT::VarDeclarationRest, {T(C::OpenBracket), N(NT::Number), T(C::CloseBracket), N(NT::ArraySizeRest)}},
+    {NT::ArraySizeRest, {T(C::Semicolon), A(PA::ArrayVarDecl)}},
+    {NT::ArraySizeRest, {T(C::OpenBracket), N(NT::Number), T(C::CloseBracket), T(C::Semicolon), A(PA::MatrixVarDecl)}},
+
+    // <type-specifier> ::= int | void
+    {NT::TypeSpecifier, {W(C::Int)}},
+    {NT::TypeSpecifier, {W(C::Void)}},
+
+    // <params> ::= <param-list> | void
+    // <param-list> ::= <param-list> , <param> | <param>
+    // <param> ::= <type-specifier> ID | <type-specifier> ID [ ]
+    {NT::Params, {W(C::Void), N(NT::ParamsAfterVoid)}},
+    {NT::Params, {W(C::Int), W(C::Identifier), N(NT::ParamArray), N(NT::ParamList)}},
+    {NT::ParamsAfterVoid, {A(PA::Discard)}},
+    {NT::ParamsAfterVoid, {W(C::Identifier), N(NT::ParamArray), N(NT::ParamList)}},
+    {NT::ParamList, {T(C::Comma), N(NT::Param), N(NT::ParamList)}},
+    {NT::ParamList, {}},
+    {NT::Param, {N(NT::TypeSpecifier), W(C::Identifier), N(NT::ParamArray)}},
+    {NT::ParamArray, {T(C::OpenBracket), T(C::CloseBracket), A(PA::ArrayParam)}},
+    {NT::ParamArray, {A(PA::ScalarParam)}},
+
+    // <fun-body> ::= [ [ <attribute-list> ] ] <fun-body> | <compound-stmt>
+    // <attribute-list> ::= <attribute-list> , ID | ID
+    {NT::FunBody, {T(C::OpenBracket), T(C::OpenBracket), W(C::Identifier), A(PA::FunAttribute),
+                   N(NT::AttributeList), T(C::CloseBracket), T(C::CloseBracket), N(NT::FunBody)}},
+    {NT::AttributeList, {T(C::Comma), W(C::Identifier), A(PA::FunAttribute), N(NT::AttributeList)}},
+    {NT::AttributeList, {}},
+
+    // <compound-stmt> ::= { <local-declarations> <statement-list> }
+    // <local-declarations> ::= <local-declarations> <var-declaration> | empty
+    // <statement-list> ::= <statement-list> <statement> | empty
+    {NT::FunBody, {T(C::OpenCurly), A(PA::EnterFunScope), N(NT::CompoundRest)}},
+    {NT::CompoundStmt, {T(C::OpenCurly), A(PA::EnterScope), N(NT::CompoundRest)}},
+    {NT::CompoundRest, {A(PA::CompoundStart), N(NT::LocalDeclarations), A(PA::StatementsStart),
+                        N(NT::StatementList), T(C::CloseCurly), A(PA::CompoundStmt), A(PA::LeaveScope)}},
+    {NT::LocalDeclarations, {N(NT::VarDeclaration), A(PA::AppendDecl), N(NT::LocalDeclarations)}},
+    {NT::LocalDeclarations, {}},
+    {NT::StatementList, {N(NT::Statement), A(PA::AppendStmt), N(NT::StatementList)}},
+    {NT::StatementList, {}},
+
+    // <statement> ::= <expression-stmt> | <compound-stmt> | <selection-stmt>
+    //              | <iteration-stmt> | <return-stmt>
+    {NT::Statement, {N(NT::ExpressionStmt)}},
+    {NT::Statement, {N(NT::CompoundStmt)}},
+    {NT::Statement, {N(NT::SelectionStmt)}},
+    {NT::Statement, {N(NT::IterationStmt)}},
+    {NT::Statement, {N(NT::ReturnStmt)}},
+
+    // <expression-stmt> ::= <expression> ; | ;
+    {NT::ExpressionStmt, {T(C::Semicolon), A(PA::NullStmt)}},
+    {NT::ExpressionStmt, {N(NT::Expression), T(C::Semicolon), A(PA::ExprStmt)}},
+
+    // <selection-stmt> ::= if ( <expression> ) <statement>
+    //                  | if ( <expression> ) <statement> else <statement>
+    {NT::SelectionStmt, {T(C::If), T(C::OpenParen), N(NT::Expression), T(C::CloseParen),
+                         N(NT::Statement), N(NT::ElsePart)}},
+    {NT::ElsePart, {T(C::Else), N(NT::Statement), A(PA::SelectionElseStmt)}},
+    {NT::ElsePart, {A(PA::SelectionStmt)}},
+
+    // <iteration-stmt> ::= while ( <expression> ) <statement>
+    {NT::IterationStmt, {T(C::While), T(C::OpenParen), N(NT::Expression), T(C::CloseParen),
+                         N(NT::Statement), A(PA::IterationStmt)}},
+
+    // <return-stmt> ::= return ; | return <expression> ;
+    {NT::ReturnStmt, {W(C::Return), N(NT::ReturnValue)}},
+    {NT::ReturnValue, {T(C::Semicolon), A(PA::ReturnStmt)}},
+    {NT::ReturnValue, {N(NT::Expression), T(C::Semicolon), A(PA::ReturnValueStmt)}},
+
+    // <expression> ::= <var> <assignop> <expression> | <simple-expression>
+    // <assignop> ::= = | += | -= | *= | /=
+    //
+    // Whether the left hand side is a <var> cannot be predicted with a bounded
+    // lookahead, thus the parser checks it once the '=' is found.
+    {NT::Expression, {N(NT::SimpleExpression), N(NT::AssignTail)}},
+    {NT::AssignTail, {A(PA::CheckAssign), N(NT::AssignOp), N(NT::Expression), A(PA::Assign)}},
+    {NT::AssignTail, {}},
+    {NT::AssignOp, {W(C::Assign)}},
+    {NT::AssignOp, {W(C::PlusAssign)}},
+    {NT::AssignOp, {W(C::MinusAssign)}},
+    {NT::AssignOp, {W(C::MultiplyAssign)}},
+    {NT::AssignOp, {W(C::DivideAssign)}},
+
+    // <simple-expression> ::= <additive-expression> <relop> <additive-expression>
+    //                       | <additive-expression>
+    // <relop> ::= <= | < | > | >= | == | !=
+    {NT::SimpleExpression, {N(NT::AdditiveExpression), N(NT::RelopTail)}},
+    {NT::RelopTail, {N(NT::Relop), N(NT::AdditiveExpression), A(PA::BinaryExpr)}},
+    {NT::RelopTail, {}},
+    {NT::Relop, {W(C::LessEqual)}},
+    {NT::Relop, {W(C::Less)}},
+    {NT::Relop, {W(C::Greater)}},
+    {NT::Relop, {W(C::GreaterEqual)}},
+    {NT::Relop, {W(C::Equal)}},
+    {NT::Relop, {W(C::NotEqual)}},
+
+    // <additive-expression> ::= <additive-expression> <addop> <term> | <term>
+    // <addop> ::= + | -
+    {NT::AdditiveExpression, {N(NT::Term), N(NT::AdditiveTail)}},
+    {NT::AdditiveTail, {N(NT::Addop), N(NT::Term), A(PA::BinaryExpr), N(NT::AdditiveTail)}},
+    {NT::AdditiveTail, {}},
+    {NT::Addop, {W(C::Plus)}},
+    {NT::Addop, {W(C::Minus)}},
+
+    // <term> ::= <term> <mulop> <factor> | <factor>
+    // <mulop> ::= * | /
+    {NT::Term, {N(NT::Factor), N(NT::TermTail)}},
+    {NT::TermTail, {N(NT::Mulop), N(NT::Factor), A(PA::BinaryExpr), N(NT::TermTail)}},
+    {NT::TermTail, {}},
+    {NT::Mulop, {W(C::Multiply)}},
+    {NT::Mulop, {W(C::Divide)}},
+
+    // <factor> ::= ( <expression> ) | <var> | <call> | NUM
+    //            | <incop> <var> | <var> <incop>
+    // <var> ::= ID | ID [ <expression> ] | ID [ <expression> ] [ <expression> ]
+    // <call> ::= ID ( <args> )
+    // <incop> ::= ++ | --
+    //
+    // The operand of an increment is checked to be a <var> the same way as
+    // the left hand side of an assignment.
+    {NT::Factor, {T(C::OpenParen), N(NT::Expression), T(C::CloseParen)}},
+    {NT::Factor, {N(NT::Number)}},
+    {NT::Factor, {W(C::Identifier), N(NT::FactorRest), N(NT::PostfixTail)}},
+    {NT::Factor, {N(NT::IncrementOp), N(NT::Factor), A(PA::CheckAssign), A(PA::PreIncrement)}},
+    {NT::FactorRest, {T(C::OpenParen), A(PA::CallStart), N(NT::Args), W(C::CloseParen), A(PA::Call)}},
+    {NT::FactorRest, {T(C::OpenBracket), N(NT::Expression), T(C::CloseBracket), N(NT::IndexRest)}},
+    {NT::FactorRest, {A(PA::Var)}},
+    {NT::IndexRest, {T(C::OpenBracket), N(NT::Expression), T(C::CloseBracket), A(PA::MatrixVar)}},
+    {NT::IndexRest, {A(PA::IndexedVar)}},
+    {NT::PostfixTail, {A(PA::CheckAssign), N(NT::IncrementOp), A(PA::PostIncrement)}},
+    {NT::PostfixTail, {}},
+    {NT::IncrementOp, {W(C::Increment)}},
+    {NT::IncrementOp, {W(C::Decrement)}},
+
+    // <args> ::= <arg-list> | empty
+    // <arg-list> ::= <arg-list> , <expression> | <expression>
+    {NT::Args, {N(NT::Expression), A(PA::AppendArg), N(NT::ArgList)}},
+    {NT::Args, {}},
+    {NT::ArgList, {T(C::Comma), N(NT::Expression), A(PA::AppendArg), N(NT::ArgList)}},
+    {NT::ArgList, {}},
+
+    // NUM
+    {NT::Number, {W(C::Number), A(PA::Number)}},
+};
+
+/// Error handling of each nonterminal, in the order of `NonTerminal`.
+constexpr NonTerminalInfo nonterminals[] = {
+    {NT::Program,            NI::Fallback},
+    {NT::DeclarationList,    NI::Report, Diag::parser_expected_type},
+    {NT::Declaration,        NI::Fallback},
+    {NT::DeclarationRest,    NI::Report, Diag::parser_expected_token, C::Semicolon},
+    {NT::VarDeclaration,     NI::Fallback},
+    {NT::VarDeclarationRest, NI::Report, Diag::parser_expected_token, C::Semicolon},
+    {NT::ArraySizeRest,      NI::Report, Diag::parser_expected_token, C::Semicolon},
+    {NT::TypeSpecifier,      NI::Report, Diag::parser_expected_type},
+    {NT::Params,             NI::Report, Diag::parser_expected_type},
+    {NT::ParamsAfterVoid,    NI::Fallback},
+    {NT::ParamList,          NI::Report, Diag::parser_expected_token, C::Comma},
+    {NT::Param,              NI::Fallback},
+    {NT::ParamArray,         NI::Fallback},
+    {NT::FunBody,            NI::Report, Diag::parser_expected_token, C::OpenCurly},
+    {NT::AttributeList,      NI::Report, Diag::parser_expected_token, C::CloseBracket},
+    {NT::CompoundStmt,       NI::Report, Diag::parser_expected_token, C::OpenCurly},
+    {NT::CompoundRest,       NI::Report, Diag::parser_expected_statement},
+    {NT::LocalDeclarations,  NI::Fallback},
+    {NT::StatementList,      NI::Report, Diag::parser_expected_statement},
+    {NT::Statement,          NI::Report, Diag::parser_expected_statement},
+    {NT::ExpressionStmt,     NI::Report, Diag::parser_expected_expression},
+    {NT::SelectionStmt,      NI::Report, Diag::parser_expected_token, C::If},
+    {NT::ElsePart,           NI::Fallback, Diag::parser_expected_token, C::Eof, true},
+    {NT::IterationStmt,      NI::Report, Diag::parser_expected_token, C::While},
+    {NT::ReturnStmt,         NI::Report, Diag::parser_expected_token, C::Return},
+    {NT::ReturnValue,        NI::Report, Diag::parser_expected_expression},
+    {NT::Expression,         NI::Report, Diag::parser_expected_expression},
+    {NT::AssignTail,         NI::Fallback},
+    {NT::AssignOp,           NI::Report, Diag::parser_expected_token, C::Assign},
+    {NT::SimpleExpression,   NI::Report, Diag::parser_expected_expression},
+    {NT::RelopTail,          NI::Fallback},
+    {NT::Relop,              NI::Report, Diag::parser_expected_expression},
+    {NT::AdditiveExpression, NI::Report, Diag::parser_expected_expression},
+    {NT::AdditiveTail,       NI::Fallback},
+    {NT::Addop,              NI::Report, Diag::parser_expected_expression},
+    {NT::Term,               NI::Report, Diag::parser_expected_expression},
+    {NT::TermTail,           NI::Fallback},
+    {NT::Mulop,              NI::Report, Diag::parser_expected_expression},
+    {NT::Factor,             NI::Report, Diag::parser_expected_expression},
+    {NT::FactorRest,         NI::Fallback},
+    {NT::IndexRest,          NI::Fallback},
+    {NT::PostfixTail,        NI::Fallback},
+    {NT::IncrementOp,        NI::Report, Diag::parser_expected_expression},
+    {NT::Args,               NI::Report, Diag::parser_expected_expression},
+    {NT::ArgList,            NI::Report, Diag::parser_expected_token, C::Comma},
+    {NT::Number,             NI::Report, Diag::parser_expected_token, C::Number},
+};
+// clang-format on
+
+constexpr size_t num_productions = std::size(productions);
+
+/// Builds the prediction table by computing the FIRST and FOLLOW sets of
+/// the grammar.
+constexpr auto build_parse_table() -> ParseTable
+{
+    static_assert(num_productions < ParseTable::no_production);
+
+    ParseTable table{};
+    std::array<bool, num_nonterminals> nullable{};
+    std::array<TerminalSet, num_nonterminals> first{};
+    std::array<TerminalSet, num_nonterminals> follow{};
+
+    for(size_t n = 0; n < num_nonterminals; ++n)
+    {
+        if(static_cast<size_t>(nonterminals[n].symbol) != n)
+            ++table.conflicts;
+        for(size_t c = 0; c < num_categories; ++c)
+            table.predict[n][c] = ParseTable::no_production;
+    }
+
+    // FIRST of a sequence of symbols, and whether the sequence is nullable.
+    auto first_of = [&](const Production& p, size_t from, bool& seq_nullable) {
+        TerminalSet result = 0;
+        seq_nullable = true;
+        for(size_t i = from; i < p.size && seq_nullable; ++i)
+        {
+            const auto symbol = p.rhs[i];
+            if(symbol.is_terminal())
+            {
+                result |= bit(symbol.category());
+                seq_nullable = false;
+            }
+            else if(symbol.kind == GrammarSymbol::NonTerminal)
+            {
+                result |= first[symbol.value];
+                seq_nullable = nullable[symbol.value];
+            }
+        }
+        return result;
+    };
+
+    for(bool changed = true; changed;)
+    {
+        changed = false;
+        for(const auto& p : productions)
+        {
+            const auto lhs = static_cast<size_t>(p.lhs);
+            bool seq_nullable = false;
+            const auto seq_first = first_of(p, 0, seq_nullable);
+            if((first[lhs] | seq_first) != first[lhs] || (seq_nullable && !nullable[lhs]))
+            {
+                first[lhs] |= seq_first;
+                nullable[lhs] = nullable[lhs] || seq_nullable;
+                changed = true;
+            }
+        }
+    }
+
+    for(bool changed = true; changed;)
+    {
+        changed = false;
+        for(const auto& p : productions)
+        {
+            for(size_t i = 0; i < p.size; ++i)
+            {
+                if(p.rhs[i].kind != GrammarSymbol::NonTerminal)
+                    continue;
+
+                bool rest_nullable = false;
+                auto trailer = first_of(p, i + 1, rest_nullable);
+                if(rest_nullable)
+                    trailer |= follow[static_cast<size_t>(p.lhs)];
+
+                auto& symbol_follow = follow[p.rhs[i].value];
+                if((symbol_follow | trailer) != symbol_follow)
+                {
+                    symbol_follow |= trailer;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::array<uint8_t, num_nonterminals> fallback{};
+    std::array<uint8_t, num_nonterminals> num_alternatives{};
+    for(size_t n = 0; n < num_nonterminals; ++n)
+        fallback[n] = ParseTable::no_production;
+
+    auto predict_on = [&](uint8_t prod, TerminalSet terminals, bool from_follow) {
+        const auto lhs = static_cast<size_t>(productions[prod].lhs);
+        for(size_t c = 0; c < num_categories; ++c)
+        {
+            if(!(terminals & (TerminalSet(1) << c)))
+                continue;
+
+            auto& cell = table.predict[lhs][c];
+            if(cell == ParseTable::no_production)
+                cell = prod;
+            else if(!(from_follow && nonterminals[lhs].greedy))
+                ++table.conflicts;
+        }
+    };
+
+    // Non-empty derivations take precedence over empty ones, which matters
+    // for greedy nonterminals only.
+    for(uint8_t prod = 0; prod < num_productions; ++prod)
+    {
+        const auto& p = productions[prod];
+        const auto lhs = static_cast<size_t>(p.lhs);
+        bool seq_nullable = false;
+        predict_on(prod, first_of(p, 0, seq_nullable), false);
+        if(seq_nullable)
+            fallback[lhs] = prod;
+        ++num_alternatives[lhs];
+    }
+
+    for(uint8_t prod = 0; prod < num_productions; ++prod)
+    {
+        const auto& p = productions[prod];
+        bool seq_nullable = false;
+        first_of(p, 0, seq_nullable);
+        if(seq_nullable)
+            predict_on(prod, follow[static_cast<size_t>(p.lhs)], true);
+    }
+
+    for(uint8_t prod = 0; prod < num_productions; ++prod)
+    {
+        const auto lhs = static_cast<size_t>(productions[prod].lhs);
+        if(num_alternatives[lhs] == 1)
+            fallback[lhs] = prod;
+    }
+
+    for(size_t n = 0; n < num_nonterminals; ++n)
+    {
+        if(nonterminals[n].recovery != NonTerminalInfo::Fallback)
+            continue;
+
+        if(fallback[n] == ParseTable::no_production)
+        {
+            ++table.conflicts;
+            continue;
+        }
+
+        for(auto& cell : table.predict[n])
+        {
+            if(cell == ParseTable::no_production)
+                cell = fallback[n];
+        }
+    }
+
+    return table;
+}
+}
+
+/// The prediction table for the C- grammar.
+constexpr ParseTable parse_table = grammar::build_parse_table();
+
+static_assert(parse_table.conflicts == 0,
+              "the C- grammar must be LL(1) and its error handling well-formed");
+}
+
+/*
+<program> ::= <declaration-list>
+<declaration-list> ::= <declaration-list> <declaration> | <declaration>
+<declaration> ::= <var-declaration> | <fun-declaration>
+
+<var-declaration> ::= <type-specifier> ID ; | <type-specifier> ID [ NUM ] ;
+                    | <type-specifier> ID [ NUM ] [ NUM ] ;
+<type-specifier> ::= int | void
+
+<fun-declaration> ::= <type-specifier> ID ( <params> ) <fun-body>
+<fun-body> ::= [ [ <attribute-list> ] ] <fun-body> | <compound-stmt>
+<attribute-list> ::= <attribute-list> , ID | ID
+<params> ::= <param-list> | void
+<param-list> ::= <param-list> , <param> | <param>
+<param> ::= <type-specifier> ID | <type-specifier> ID [ ]
+
+<compound-stmt> ::= { <local-declarations> <statement-list> }
+
+<local-declarations> ::= <local-declarations> <var-declaration> | empty
+<statement-list> ::= <statement-list> <statement> | empty
+
+<statement> ::= <expression-stmt> | <compound-stmt> | <selection-stmt>
+              | <iteration-stmt> | <return-stmt>
+<expression-stmt> ::= <expression> ; | ;
+
+<selection-stmt> ::= if ( <expression> ) <statement>
+                  | if ( <expression> ) <statement> else <statement>
+
+<iteration-stmt> ::= while ( <expression> ) <statement>
+
+<return-stmt> ::= return ; | return <expression> ;
+
+<expression> ::= <var> <assignop> <expression> | <simple-expression>
+<assignop> ::= = | += | -= | *= | /=
+<var> ::= ID | ID [ <expression> ] | ID [ <expression> ] [ <expression> ]
+
+<simple-expression> ::= <additive-expression> <relop> <additive-expression>
+                      | <additive-expression>
+<relop> ::= <= | < | > | >= | == | !=
+
+<additive-expression> ::= <additive-expression> <addop> <term> | <term>
+<addop ::= + | -
+<term> ::= <term> <mulop> <factor> | <factor>
+<mulop> ::= * | /
+
+<factor> ::= ( <expression> ) | <var> | <call> | NUM
+           | <incop> <var> | <var> <incop>
+<incop> ::= ++ | --
+
+<call> ::= ID ( <args> )
+<args> ::= <arg-list> | empty
+<arg-list> ::= <arg-list> , <expression> | <expression>
+*/
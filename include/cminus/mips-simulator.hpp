@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cminus
+{
+/// An assembled MIPS program, ready to be run by `simulate`.
+///
+/// The assembler understands the subset of the spim assembly language used
+/// by the generated code and its runtime: the integer instructions of
+/// MIPS32, the common pseudo-instructions (e.g. `li`, `la`, `move`, `blt`)
+/// and the `.data`, `.text`, `.align`, `.space`, `.word`, `.byte`, `.ascii`
+/// and `.asciiz` directives. Other directives (e.g. `.globl`) are ignored.
+class MipsProgram
+{
+public:
+    /// The operations of the simulated machine.
+    ///
+    /// Pseudo-instructions map to a single operation.
+    enum class Op : uint8_t
+    {
+        Add,
+        Addu,
+        Sub,
+        Subu,
+        And,
+        Or,
+        Xor,
+        Nor,
+        Slt,
+        Sltu,
+        Sllv,
+        Srlv,
+        Srav,
+        Mul,
+        Sll,
+        Srl,
+        Sra,
+        Addi,
+        Addiu,
+        Andi,
+        Ori,
+        Xori,
+        Slti,
+        Sltiu,
+        Lui,
+        Li,
+        Move,
+        Mult,
+        Multu,
+        Div,
+        Divu,
+        Mfhi,
+        Mflo,
+        Mthi,
+        Mtlo,
+        Lw,
+        Lh,
+        Lhu,
+        Lb,
+        Lbu,
+        Sw,
+        Sh,
+        Sb,
+        Beq,
+        Bne,
+        Blt,
+        Ble,
+        Bgt,
+        Bge,
+        Blez,
+        Bgtz,
+        Bltz,
+        Bgez,
+        Bltzal,
+        Bgezal,
+        J,
+        Jal,
+        Jr,
+        Jalr,
+        Syscall,
+        Break,
+        Nop,
+    };
+
+    /// An instruction, with its labels already resolved.
+    ///
+    /// Memory operands address `imm + rs`. Branch and jump targets are
+    /// indices into the instructions.
+    struct Instr
+    {
+        Op op;
+        uint8_t rd = 0;
+        uint8_t rs = 0;
+        uint8_t rt = 0;
+        int32_t imm = 0;
+    };
+
+    /// Where the segments of the program are placed, as in spim.
+    static constexpr uint32_t text_base = 0x00400000;
+    static constexpr uint32_t data_base = 0x10010000;
+
+    /// Assembles a program from its assembly text.
+    ///
+    /// \returns the program or `std::nullopt` if the text is malformed, in
+    ///          which case `error` describes the first problem found.
+    static auto assemble(std::string_view source, std::string& error)
+            -> std::optional<MipsProgram>;
+
+    auto instructions() const -> const std::vector<Instr>&
+    {
+        return text;
+    }
+
+    /// Gets the initial contents of the data segment.
+    auto data_segment() const -> const std::vector<uint8_t>&
+    {
+        return data;
+    }
+
+    /// Gets the index of the instruction execution begins at (`main`).
+    auto entry() const -> size_t
+    {
+        return entry_index;
+    }
+
+private:
+    std::vector<Instr> text;
+    std::vector<uint8_t> data;
+    size_t entry_index = 0;
+};
+
+/// The resources a simulated program may use.
+struct SimulationLimits
+{
+    /// The maximum number of instructions executed.
+    uint64_t max_instructions = 100'000'000;
+
+    /// The maximum amount of memory, in bytes, touched by the data segment,
+    /// the heap and the stack together. It is accounted in 4 KiB pages.
+    uint64_t max_memory = 16 * 1024 * 1024;
+};
+
+/// Why a simulated program stopped.
+enum class ExitReason : uint8_t
+{
+    Exit,              //< returned from `main` or called exit
+    InstructionBudget, //< ran out of instructions
+    MemoryBudget,      //< ran out of memory
+    Fault,             //< did something the machine cannot do
+};
+
+struct SimulationResult
+{
+    ExitReason reason = ExitReason::Exit;
+
+    /// The number of instructions executed, counting each
+    /// pseudo-instruction once.
+    uint64_t instructions = 0;
+
+    /// Everything printed by the program.
+    std::string output;
+
+    /// What went wrong, if the program faulted.
+    std::string fault;
+};
+
+/// Runs a program in a sandbox with the given standard input.
+///
+/// The program only interacts with the outside world through its standard
+/// input and output. The syscalls of spim for printing, reading and exiting
+/// are provided, and so is `sbrk`, whereas opening files always fails.
+/// Reading an integer consumes a whole line, as in spim.
+///
+/// Overflows in `add`, `addi` and `sub` fault, as the exception spim raises
+/// for them would, and dividing by zero leaves `hi` and `lo` untouched.
+auto simulate(const MipsProgram& program,
+              std::string_view input,
+              const SimulationLimits& limits) -> SimulationResult;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cminus/grammar.hpp>
+#include <cminus/semantics.hpp>
+#include <variant>
+
+namespace cminus
+{
+// The parser is parameterized on an actions policy, which receives the
+// words matched by `GrammarSymbol::TerminalWord` symbols and runs the
+// `ParseAction`s of the derived productions. A policy must provide:
+//
+//  + `Result`, the type returned by `parse_program`.
+//  + `void push_word(const Word&)`.
+//  + `bool run_action(ParseAction)`, returning whether parsing may proceed.
+//  + `auto accept() -> Result`, called once the whole input is derived.
+//  + `auto reject() -> Result`, called once parsing fails.
+
+/// Actions that build an abstract syntax tree through the semantic analyzer.
+///
+/// The semantic values of the derived symbols are kept in a stack. Each
+/// action pops the values of the symbols it consumes and pushes its result.
+class SemaActions
+{
+public:
+    using Result = std::shared_ptr<ASTProgram>;
+
+    // Not explicit so that a `Parser` can be constructed from a `Semantics`.
+    SemaActions(Semantics& sema) :
+        sema(sema)
+    {
+    }
+
+    void push_word(const Word& word) { values.emplace_back(word); }
+
+    bool run_action(ParseAction action);
+
+    auto accept() -> Result;
+
+    auto reject() -> Result;
+
+private:
+    /// Semantic value of a derived symbol.
+    using Value = std::variant<Word,
+                               std::shared_ptr<ASTProgram>,
+                               std::shared_ptr<ASTVarDecl>,
+                               std::shared_ptr<ASTFunDecl>,
+                               std::shared_ptr<ASTStmt>,
+                               std::shared_ptr<ASTExpr>,
+                               std::vector<std::shared_ptr<ASTVarDecl>>,
+                               std::vector<std::shared_ptr<ASTStmt>>,
+                               std::vector<std::shared_ptr<ASTExpr>>>;
+
+    /// Pops the value at the top of the value stack.
+    template<typename T>
+    auto pop_value() -> T
+    {
+        assert(!values.empty());
+        auto value = std::get<T>(std::move(values.back()));
+        values.pop_back();
+        return value;
+    }
+
+    /// \returns the value at the top of the value stack.
+    template<typename T>
+    auto top_value() -> T&
+    {
+        assert(!values.empty());
+        return std::get<T>(values.back());
+    }
+
+private:
+    Semantics& sema;
+
+    /// Semantic values of the derived symbols, top of the stack at the back.
+    std::vector<Value> values;
+    /// Number of scopes entered by actions and not yet left.
+    size_t open_scopes = 0;
+};
+
+/// Actions that build nothing at all, for checking syntax only.
+class SyntaxActions
+{
+public:
+    using Result = bool;
+
+    void push_word(const Word&) {}
+
+    bool run_action(ParseAction) { return true; }
+
+    auto accept() -> Result { return true; }
+
+    auto reject() -> Result { return false; }
+};
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+
+namespace cminus
+{
+/// Hardware performance counters of the calling thread.
+///
+/// The counters are read through `perf_event_open`, thus only on Linux.
+/// Each counter that cannot be opened (e.g. the hardware lacks it or the
+/// kernel forbids it) is simply unavailable.
+class PerfCounters
+{
+public:
+    enum Event : uint8_t
+    {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        CacheMisses,
+        NumEvents,
+    };
+
+    /// The values of the counters at some point, or `std::nullopt` for
+    /// counters that are unavailable.
+    struct Sample
+    {
+        std::optional<uint64_t> values[NumEvents];
+    };
+
+    /// Opens and starts the counters.
+    explicit PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// \returns whether any of the counters is available.
+    bool available() const;
+
+    /// Reads the counters.
+    ///
+    /// Values are scaled up for the time a counter was not actually
+    /// counting, which happens when there are more events than hardware
+    /// counters.
+    auto read() const -> Sample;
+
+    /// \returns the name of an event, as given by `perf list`.
+    static auto event_name(Event event) -> const char*;
+
+private:
+    int fds[NumEvents];
+};
+}
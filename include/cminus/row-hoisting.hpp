@@ -0,0 +1,47 @@
+#pragma once
+#include <cminus/alias-analysis.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace cminus
+{
+/// A row of a two-dimensional array whose address is computed once before
+/// a loop rather than on each access to its elements.
+struct HoistedRow
+{
+    ASTVarDecl* array;
+    ASTExpr* index; //< the row subscript of one of the accesses
+    int id;         //< identifies the row among those of the function
+};
+
+/// Hoisting of the row addresses of two-dimensional arrays out of loops.
+///
+/// An element `m[i][j]` accessed in a while statement goes through a row
+/// computed before the statement, provided that the row subscript is a
+/// number or a scalar variable the statement does not modify, either by
+/// itself or through its calls. Accesses with the same array and row
+/// subscript share the row. Rows are hoisted out of the outermost loop
+/// they are invariant in.
+///
+/// The row is computed even if the loop ends up not accessing it, thus a
+/// negative row subscript must not trap until an element is accessed.
+class RowHoisting
+{
+public:
+    explicit RowHoisting(ASTFunDecl& fun, const AliasAnalysis& aliases);
+
+    /// \returns the rows hoisted out of a loop, which are not hoisted out of
+    /// any enclosing loop.
+    auto get_hoisted(const ASTIterationStmt& loop) const
+            -> const std::vector<HoistedRow>&;
+
+    /// \returns the identifier of the hoisted row an element access goes
+    /// through, or -1 if none.
+    int get_row_id(const ASTVarRef& var_ref) const;
+
+private:
+    std::unordered_map<const ASTIterationStmt*, std::vector<HoistedRow>> hoisted;
+    std::unordered_map<const ASTVarRef*, int> row_of;
+    std::vector<HoistedRow> none;
+};
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cminus/alias-analysis.hpp>
+#include <cminus/cfg.hpp>
+#include <unordered_map>
+
+namespace cminus
+{
+/// How the code generator should perform an access to an array element.
+struct ElementAccess
+{
+    enum Kind : uint8_t
+    {
+        Memory, //< access memory as usual
+        Keep,   //< access memory as usual, then keep the element in `reg`
+        Reuse,  //< (load only) the element is already in `reg`
+        Defer,  //< (store only) only keep the element in `reg`, a later
+                //< store of the same element writes it back to memory
+    };
+
+    Kind kind = Memory;
+    uint8_t reg = 0;
+};
+
+/// Scalar replacement of array elements.
+///
+/// Elements accessed through a subscript that is a scalar variable or a
+/// number (e.g. `a[i]` and `a[3]`) are kept in registers for as long as no
+/// intervening code may have modified them. This saves the address
+/// computation, bounds check and load of the next accesses to the same
+/// element. A store is forwarded to subsequent loads, and of consecutive
+/// stores to the same element within a block only the last one is
+/// written back to memory.
+///
+/// The caller-saved registers `$t1`-`$t9` are used, thus nothing is kept
+/// across calls, and calls force pending stores to memory. Otherwise a
+/// store going out of bounds could stop the program after the output of a
+/// call rather than before it.
+class ScalarReplacement
+{
+public:
+    explicit ScalarReplacement(const CFG& cfg, const AliasAnalysis& aliases);
+
+    /// \returns how to perform the access to an element made by either a
+    /// subscripted `ASTVarRef` or an assignment into one.
+    auto get_access(const ASTExpr& expr) const -> ElementAccess;
+
+private:
+    std::unordered_map<const ASTExpr*, ElementAccess> accesses;
+};
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include <cassert>
+#include <cminus/compilation-budget.hpp>
 #include <cminus/diagnostics.hpp>
 #include <cminus/sourceman.hpp>
 #include <optional>
+#include <string_view>
 
 namespace cminus
 {
@@ -30,6 +32,12 @@ enum class Category
     Equal,
     NotEqual,
     Assign,
+    PlusAssign,
+    MinusAssign,
+    MultiplyAssign,
+    DivideAssign,
+    Increment,
+    Decrement,
     Semicolon,
     Comma,
     OpenParen,
@@ -75,6 +83,189 @@ struct Word
     }
 };
 
+/// A word classified by `scan_lexeme`, or a lexical error found instead.
+struct Lexeme
+{
+    Category category = Category::Eof;
+    bool is_error = false;
+    Diag error = Diag::lexer_bad_char; //< the lexical error, if `is_error`
+    size_t begin = 0;                  //< where the word, or the error range, begins
+    size_t end = 0;                    //< where the word, or the error range, ends
+    size_t next = 0;                   //< where scanning resumes
+};
+
+constexpr bool is_letter(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool is_digit(char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+constexpr bool is_space(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n');
+}
+
+/// \returns the category of a keyword, or `Category::Identifier`.
+constexpr auto keyword_category(std::string_view lexeme) -> Category
+{
+    if(lexeme == "if")
+        return Category::If;
+    else if(lexeme == "else")
+        return Category::Else;
+    else if(lexeme == "int")
+        return Category::Int;
+    else if(lexeme == "void")
+        return Category::Void;
+    else if(lexeme == "return")
+        return Category::Return;
+    else if(lexeme == "while")
+        return Category::While;
+    else
+        return Category::Identifier;
+}
+
+/// Classifies the word of `text` starting at `pos`, skipping whitespace
+/// and comments before it.
+///
+/// The text ends at its size or at its first null character, whichever
+/// comes first. Lexical errors are returned one at a time, so that the
+/// caller decides whether to report them and scan on from `next`.
+///
+/// This is the automaton of `Scanner`, which is usable in constant
+/// expressions as well (see `static-checker.hpp`).
+constexpr auto scan_lexeme(std::string_view text, size_t pos) -> Lexeme
+{
+    auto at = [&](size_t i) { return i < text.size() ? text[i] : '\0'; };
+    auto word = [&](Category category, size_t begin, size_t end) {
+        Lexeme lexeme;
+        lexeme.category = category;
+        lexeme.begin = begin;
+        lexeme.end = end;
+        lexeme.next = end;
+        return lexeme;
+    };
+    auto error = [&](Diag diag, size_t begin, size_t end, size_t next) {
+        Lexeme lexeme = word(Category::Eof, begin, end);
+        lexeme.is_error = true;
+        lexeme.error = diag;
+        lexeme.next = next;
+        return lexeme;
+    };
+
+    while(true)
+    {
+        const auto start = pos;
+        const auto c = at(pos++);
+
+        if(c == '\0')
+            return word(Category::Eof, start, start);
+
+        if(is_space(c))
+            continue;
+
+        if(is_digit(c))
+        {
+            while(is_digit(at(pos)))
+                ++pos;
+            if(!is_letter(at(pos)))
+                return word(Category::Number, start, pos);
+
+            // Something is wrong with this number. Skip to the next token.
+            while(is_digit(at(pos)) || is_letter(at(pos)))
+                ++pos;
+            return error(Diag::lexer_bad_number, start, pos, pos);
+        }
+
+        if(is_letter(c))
+        {
+            while(is_letter(at(pos)) || is_digit(at(pos)))
+                ++pos;
+            return word(keyword_category(text.substr(start, pos - start)), start, pos);
+        }
+
+        // Operators which may be followed by an '=' to form another one.
+        auto with_equal = [&](Category alone, Category equal) {
+            if(at(pos) != '=')
+                return word(alone, start, pos);
+            return word(equal, start, pos + 1);
+        };
+
+        switch(c)
+        {
+            case '/':
+                if(at(pos) != '*')
+                    return with_equal(Category::Divide, Category::DivideAssign);
+
+                // Find the end of the comment and try another word afterwards.
+                for(++pos; at(pos) != '\0'; ++pos)
+                {
+                    if(at(pos) == '*' && at(pos + 1) == '/')
+                        break;
+                }
+
+                // End of stream but no end of comment found.
+                if(at(pos) == '\0')
+                    return error(Diag::lexer_unclosed_comment, start, start + 2, pos);
+
+                pos += 2;
+                continue;
+
+            case '*':
+                return with_equal(Category::Multiply, Category::MultiplyAssign);
+            case '-':
+                if(at(pos) == '-')
+                    return word(Category::Decrement, start, pos + 1);
+                return with_equal(Category::Minus, Category::MinusAssign);
+            case '+':
+                if(at(pos) == '+')
+                    return word(Category::Increment, start, pos + 1);
+                return with_equal(Category::Plus, Category::PlusAssign);
+            case '<':
+                return with_equal(Category::Less, Category::LessEqual);
+            case '>':
+                return with_equal(Category::Greater, Category::GreaterEqual);
+            case '=':
+                return with_equal(Category::Assign, Category::Equal);
+            case '!':
+                if(at(pos) == '=')
+                    return word(Category::NotEqual, start, pos + 1);
+                break;
+            case ';':
+                return word(Category::Semicolon, start, pos);
+            case ',':
+                return word(Category::Comma, start, pos);
+            case '(':
+                return word(Category::OpenParen, start, pos);
+            case ')':
+                return word(Category::CloseParen, start, pos);
+            case '[':
+                return word(Category::OpenBracket, start, pos);
+            case ']':
+                return word(Category::CloseBracket, start, pos);
+            case '{':
+                return word(Category::OpenCurly, start, pos);
+            case '}':
+                return word(Category::CloseCurly, start, pos);
+            default:
+                break;
+        }
+
+        // We found a character that is not part of our alphabet.
+        return error(Diag::lexer_bad_char, start, start + 1, start + 1);
+    }
+}
+
+/// Counters of the words classified by a scanner.
+struct ScannerStats
+{
+    /// The number of words of each category, indexed by `Category`.
+    uint32_t words[static_cast<size_t>(Category::Eof) + 1] = {};
+};
+
 /// The scanner transforms a stream of characters into a stream of words.
 class Scanner
 {
@@ -99,22 +290,41 @@ public:
     /// as Category::Eof.
     ///
     /// \returns the classified word.
-    auto next_word() -> Word;
+    auto next_word() -> Word
+    {
+        // Pretend the stream ended so that no more work is done.
+        if(budget && budget->poll())
+            return Word(Category::Eof, current_pos, current_pos);
+
+        auto word = scan_word();
+        if(stats)
+            ++this->stats->words[static_cast<size_t>(word.category)];
+        return word;
+    }
+
+    /// Counts the words classified from now on into `stats`.
+    void record_stats(ScannerStats& stats)
+    {
+        this->stats = &stats;
+    }
+
+    /// Polls `budget` for every word classified from now on.
+    void set_budget(CompilationBudget& budget)
+    {
+        this->budget = &budget;
+    }
 
     /// \returns the source file associated with this scanner.
     const SourceFile& get_source() const { return source; }
 
 private:
-    static bool is_letter(char c);
-    static bool is_digit(char c);
-    static bool is_space(char c);
-
-    bool lex_identifier(SourceLocation& out_pos);
-    bool lex_number(SourceLocation& out_pos);
+    auto scan_word() -> Word;
 
 private:
     const SourceFile& source;
     DiagnosticManager& diagman;
     SourceLocation current_pos;
+    ScannerStats* stats = nullptr;
+    CompilationBudget* budget = nullptr;
 };
 }
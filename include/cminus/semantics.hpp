@@ -1,5 +1,6 @@
 #pragma once
 #include <cminus/ast.hpp>
+#include <cminus/compilation-budget.hpp>
 #include <cminus/diagnostics.hpp>
 #include <cminus/sourceman.hpp>
 #include <unordered_map>
@@ -76,6 +77,9 @@ public:
     auto insert(SourceRange name, std::shared_ptr<ASTDecl> decl)
             -> std::pair<std::shared_ptr<ASTDecl>, bool>;
 
+    /// Gets the enclosing scope, if any.
+    auto get_parent() const -> const Scope* { return parent_scope.get(); }
+
     /// Checks whether this is the scope of function parameters.
     bool is_params_scope() const { return !!(flags & ScopeFlags::FunParamsScope); }
 
@@ -85,6 +89,14 @@ private:
     ScopeFlags flags;
 };
 
+/// Counters of the work done by a semantic analyzer.
+struct SemaStats
+{
+    uint32_t scopes = 0;        //< scopes entered
+    uint32_t lookups = 0;       //< names looked up
+    uint32_t lookup_misses = 0; //< symbol tables searched without finding a name
+};
+
 /// The semantic analyzer performs context-sensitive analysis, type-checking,
 /// and AST building. It is driven by actions called from within the parser.
 class Semantics
@@ -108,8 +120,11 @@ public:
                                std::shared_ptr<ASTDecl> decl);
 
     /// Acts on the declaration of a new variable.
+    ///
+    /// Two-dimensional arrays have `array_cols` columns.
     auto act_on_var_decl(const Word& type, const Word& name,
-                         std::shared_ptr<ASTNumber> array_size)
+                         std::shared_ptr<ASTNumber> array_size,
+                         std::shared_ptr<ASTNumber> array_cols)
             -> std::shared_ptr<ASTVarDecl>;
 
     /// Acts on the declaration of a new function, but before its parameters
@@ -122,6 +137,11 @@ public:
     auto act_on_fun_decl_end(std::shared_ptr<ASTFunDecl>)
             -> std::shared_ptr<ASTFunDecl>;
 
+    /// Acts on an attribute given to a function.
+    ///
+    /// \returns whether the attribute is known and agrees with the others.
+    bool act_on_fun_attribute(ASTFunDecl& decl, const Word& name);
+
     /// Acts on the declaration of a parameter.
     auto act_on_param_decl(const Word& type, const Word& name, bool is_array)
             -> std::shared_ptr<ASTParmVarDecl>;
@@ -164,6 +184,17 @@ public:
                        const Word& op)
             -> std::shared_ptr<ASTAssignExpr>;
 
+    /// Acts on a compound assignment expression, such as `x += e`.
+    auto act_on_compound_assign(std::shared_ptr<ASTVarRef> lhs,
+                                std::shared_ptr<ASTExpr> rhs,
+                                const Word& op)
+            -> std::shared_ptr<ASTCompoundAssignExpr>;
+
+    /// Acts on an increment or decrement of a variable.
+    auto act_on_increment(std::shared_ptr<ASTVarRef> var,
+                          const Word& op, bool is_postfix)
+            -> std::shared_ptr<ASTCompoundAssignExpr>;
+
     /// Acts on a binary expression.
     auto act_on_binary_expr(std::shared_ptr<ASTExpr> lhs,
                             std::shared_ptr<ASTExpr> rhs,
@@ -175,7 +206,10 @@ public:
             -> std::shared_ptr<ASTNumber>;
 
     /// Acts on reference to a variable.
-    auto act_on_var(const Word& name, std::shared_ptr<ASTExpr> index)
+    ///
+    /// Elements of two-dimensional arrays have a `col_index` as well.
+    auto act_on_var(const Word& name, std::shared_ptr<ASTExpr> index,
+                    std::shared_ptr<ASTExpr> col_index)
             -> std::shared_ptr<ASTVarRef>;
 
     /// Acts on a function call.
@@ -190,34 +224,68 @@ public:
     /// Gets the current scope.
     Scope& get_scope();
 
-protected:
-    friend class ParseScope;
+    /// Gets the source ranges of the expressions built so far.
+    auto get_source_table() const -> const ASTSourceTable&
+    {
+        return *source_table;
+    }
 
     /// Enters a new scope.
     ///
-    /// \note use `ParseScope` instead of this method.
+    /// \note each call must be paired with a `leave_scope` call. Consider
+    /// using `ParseScope` for that.
     void enter_scope(ScopeFlags flags);
 
     /// Leaves the previous scope.
-    ///
-    /// \note use `ParseScope` instead of this method.
     void leave_scope();
 
+    /// Counts the work done from now on into `stats`.
+    void record_stats(SemaStats& stats)
+    {
+        this->stats = &stats;
+    }
+
+    /// Charges every AST node built from now on to `budget`.
+    void set_budget(CompilationBudget& budget)
+    {
+        this->budget = &budget;
+    }
+
 private:
-    auto make_builtin(Category retn_type,
+    /// Builds an AST node, charging it to the budget.
+    template<typename Node, typename... Args>
+    auto make_node(Args&&... args) -> std::shared_ptr<Node>
+    {
+        if(budget)
+            budget->charge_ast_node(sizeof(Node));
+        return std::make_shared<Node>(std::forward<Args>(args)...);
+    }
+
+    /// Looks up a name from the current scope outwards.
+    auto lookup(SourceRange name) -> std::shared_ptr<ASTDecl>;
+
+    auto make_builtin(ExprType retn_type,
                       std::string name,
                       std::vector<std::string> params)
             -> std::shared_ptr<ASTFunDecl>;
 
+    /// \returns the source range from the start of `lhs` to the end of `rhs`.
+    auto join_ranges(const ASTExpr& lhs, const ASTExpr& rhs) const
+            -> SourceRange;
+
 private:
     SourceFile& source;
     DiagnosticManager& diagman;
     std::unique_ptr<Scope> current_scope;
+    std::shared_ptr<ASTSourceTable> source_table;
 
     std::shared_ptr<ASTFunDecl> fun_println;
     std::shared_ptr<ASTFunDecl> fun_input;
+    std::shared_ptr<ASTFunDecl> fun_alloc;
 
     bool is_current_fun_void = true;
+    SemaStats* stats = nullptr;
+    CompilationBudget* budget = nullptr;
 };
 
 /// This object retains the ownership of a semantic scope.
@@ -3,6 +3,7 @@
 #include <memory>
 #include <optional>
 #include <set>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -32,6 +33,9 @@ public:
 
     /// Constructs a source file from a file stream.
     ///
+    /// The size of seekable streams is found beforehand, so that they are
+    /// read at once unless a `hint_size` is given.
+    ///
     /// \returns The newly created source file or `std::nullopt` when a
     ///          stream failure occurs. Call `std::ferror` for error details.
     static auto from_stream(std::FILE* stream, size_t hint_size = -1)
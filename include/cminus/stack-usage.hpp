@@ -0,0 +1,40 @@
+#pragma once
+#include <cminus/ast-codegen-visitor.hpp>
+#include <vector>
+
+namespace cminus
+{
+/// The stack usage of a function.
+struct StackUsage
+{
+    ASTFunDecl* fun;
+
+    /// The size in bytes of the stack frame of the function.
+    uint32_t frame_size = 0;
+
+    /// The worst-case size in bytes of the stack used by a call to the
+    /// function, including its callees. Only meaningful if not `unbounded`.
+    uint32_t max_depth = 0;
+
+    /// Whether the function is part of a cycle in the call graph.
+    bool recursive = false;
+
+    /// Whether the stack depth has no static bound, because the function
+    /// is recursive or may call a recursive function.
+    bool unbounded = false;
+
+    /// If bounded, the chain of calls using the most stack, beginning with
+    /// this function. Otherwise, the chain of calls reaching recursion,
+    /// ending in the first function called again.
+    std::vector<ASTFunDecl*> chain;
+};
+
+/// Computes the worst-case stack usage of each function in a program from
+/// the stack frames found by the code generator and the call graph.
+///
+/// Builtin functions use no stack.
+auto compute_stack_usage(
+        ASTProgram& program,
+        const std::unordered_map<ASTFunDecl*, ASTCodegenVisitor::FrameInfo>& frames)
+        -> std::vector<StackUsage>;
+}
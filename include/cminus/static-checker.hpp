@@ -0,0 +1,697 @@
+#pragma once
+#include <array>
+#include <cminus/ast.hpp>
+#include <cminus/diagnostics.hpp>
+#include <cminus/grammar.hpp>
+#include <cminus/scanner.hpp>
+#include <cstdint>
+#include <string_view>
+
+// This is a front end for C- programs known at C++ compile time, such as
+// snippets embedded as string literals into a host program. It lexes, parses
+// and type-checks a program in a constant expression:
+//
+//     static_assert(cminus::check_program("void main(void) { println(42); }"));
+//
+// The program is scanned by the automaton of the `Scanner` (`scan_lexeme`)
+// and derived through the same prediction table as the `Parser`. The checks
+// of `Semantics` are performed as well, but no abstract syntax tree is built.
+// Since dynamic allocation is not allowed in constant expressions, every
+// table lives in a fixed-capacity arena, and programs too large for them
+// are rejected as such.
+//
+// Checking stops at the first problem found.
+
+namespace cminus
+{
+/// The outcome of checking a program with `check_program`.
+struct StaticCheckResult
+{
+    enum Status : uint8_t
+    {
+        Ok,       //< the program is valid
+        Error,    //< the program is not valid
+        TooLarge, //< the program does not fit in the arenas of the checker
+    };
+
+    Status status = Ok;
+    Diag diag = Diag::parser_expected_token; //< the first problem found, on `Error`
+    Category expected = Category::Eof;       //< the argument of `Diag::parser_expected_token`
+    size_t offset = 0;                       //< where the problem was found in the source
+
+    constexpr explicit operator bool() const { return status == Ok; }
+};
+
+/// A stack of fixed capacity, usable in constant expressions.
+template<typename T, size_t Capacity>
+class FixedStack
+{
+public:
+    constexpr bool push(const T& value)
+    {
+        if(count == Capacity)
+            return false;
+        this->elements[count++] = value;
+        return true;
+    }
+
+    constexpr auto pop() -> T
+    {
+        return elements[--count];
+    }
+
+    constexpr auto top() -> T& { return elements[count - 1]; }
+
+    constexpr auto operator[](size_t i) -> T& { return elements[i]; }
+
+    constexpr auto size() const -> size_t { return count; }
+
+    constexpr bool empty() const { return count == 0; }
+
+    /// Drops the elements above the first `size` ones.
+    constexpr void resize(size_t size) { this->count = size; }
+
+private:
+    std::array<T, Capacity> elements{};
+    size_t count = 0;
+};
+
+/// The checker behind `check_program`.
+///
+/// This plays the role of the `Scanner`, the `Parser` and `Semantics` at
+/// once. It is an actions policy of its own, see `parse-actions.hpp`.
+class StaticChecker
+{
+public:
+    static constexpr size_t max_parse_stack = 256;
+    static constexpr size_t max_values = 128;
+    static constexpr size_t max_symbols = 256;
+    static constexpr size_t max_params = 256;
+    static constexpr size_t max_scopes = 64;
+    static constexpr size_t max_args = 64;
+
+    constexpr explicit StaticChecker(std::string_view source) :
+        source(source)
+    {
+    }
+
+    /// Checks the whole program.
+    constexpr auto check_program() -> StaticCheckResult;
+
+private:
+    /// What a symbol of the program names.
+    enum class SymbolKind : uint8_t
+    {
+        Var,
+        Array,
+        Matrix, //< two-dimensional array
+        Fun,
+    };
+
+    struct Symbol
+    {
+        std::string_view name;
+        SymbolKind kind = SymbolKind::Var;
+        bool is_void = false;    //< whether a function returns nothing
+        bool is_array = false;   //< whether a builtin returns an array
+        size_t first_param = 0;  //< index of the first parameter of a function
+        size_t num_params = 0;   //< number of parameters of a function
+    };
+
+    struct Scope
+    {
+        size_t first_symbol = 0; //< symbols above this one belong to the scope
+        bool is_params = false;  //< whether this is the scope of function parameters
+    };
+
+    /// Semantic value of a derived symbol, in place of the AST nodes.
+    struct Value
+    {
+        Category category = Category::Eof; //< the category of a word
+        ExprType type = ExprType::Int;     //< the type of an expression
+        size_t begin = 0;                  //< where the word or expression begins
+        size_t end = 0;                    //< where the word or expression ends
+        size_t index = 0;                  //< the symbol of a declaration, or the first argument of a call
+    };
+
+    struct Arg
+    {
+        ExprType type = ExprType::Int;
+        size_t begin = 0;
+    };
+
+    constexpr auto lexeme(const Value& word) const -> std::string_view
+    {
+        return source.substr(word.begin, word.end - word.begin);
+    }
+
+    /// \returns the value of a number, which is known to fit a word.
+    constexpr auto number(const Value& word) const -> int64_t
+    {
+        int64_t value = 0;
+        for(auto c : lexeme(word))
+            value = value * 10 + (c - '0');
+        return value;
+    }
+
+    constexpr bool fail(Diag diag, size_t offset)
+    {
+        this->result.status = StaticCheckResult::Error;
+        this->result.diag = diag;
+        this->result.offset = offset;
+        return false;
+    }
+
+    constexpr bool fail_too_large()
+    {
+        this->result.status = StaticCheckResult::TooLarge;
+        return false;
+    }
+
+    constexpr bool push(const Value& value)
+    {
+        return values.push(value) || fail_too_large();
+    }
+
+    constexpr bool push_expr(ExprType type, size_t begin, size_t end)
+    {
+        Value value;
+        value.type = type;
+        value.begin = begin;
+        value.end = end;
+        return push(value);
+    }
+
+    /// Scans the next word, failing on lexical errors.
+    constexpr bool next_word(Value& word)
+    {
+        const auto lexeme = scan_lexeme(source, current_pos);
+        if(lexeme.is_error)
+            return fail(lexeme.error, lexeme.begin);
+        this->current_pos = lexeme.next;
+        word.category = lexeme.category;
+        word.begin = lexeme.begin;
+        word.end = lexeme.end;
+        return true;
+    }
+
+    /// Looks up a name from the current scope outwards.
+    ///
+    /// \returns the index of the symbol or `max_symbols` if none.
+    constexpr auto lookup(std::string_view name, size_t first_symbol = 0) -> size_t
+    {
+        for(size_t i = symbols.size(); i > first_symbol; --i)
+        {
+            if(symbols[i - 1].name == name)
+                return i - 1;
+        }
+        return max_symbols;
+    }
+
+    /// Inserts a symbol into the current scope, failing on redefinitions.
+    constexpr bool insert(const Value& name, SymbolKind kind, bool is_void)
+    {
+        // The body of a function may not redeclare its parameters.
+        auto first_symbol = scopes.top().first_symbol;
+        if(scopes.size() > 1 && scopes[scopes.size() - 2].is_params)
+            first_symbol = scopes[scopes.size() - 2].first_symbol;
+
+        if(lookup(lexeme(name), first_symbol) != max_symbols)
+            return fail(Diag::sema_redefinition, name.begin);
+
+        Symbol symbol;
+        symbol.name = lexeme(name);
+        symbol.kind = kind;
+        symbol.is_void = is_void;
+        symbol.first_param = params.size();
+        return symbols.push(symbol) || fail_too_large();
+    }
+
+    constexpr bool enter_scope(bool is_params)
+    {
+        Scope scope;
+        scope.first_symbol = symbols.size();
+        scope.is_params = is_params;
+        return scopes.push(scope) || fail_too_large();
+    }
+
+    constexpr void leave_scope()
+    {
+        this->symbols.resize(scopes.pop().first_symbol);
+    }
+
+    /// Declares one of the builtin functions.
+    constexpr bool make_builtin(std::string_view name, ExprType retn_type, size_t num_params)
+    {
+        Symbol symbol;
+        symbol.name = name;
+        symbol.kind = SymbolKind::Fun;
+        symbol.is_void = (retn_type == ExprType::Void);
+        symbol.is_array = (retn_type == ExprType::Array);
+        symbol.first_param = params.size();
+        symbol.num_params = num_params;
+        for(size_t i = 0; i < num_params; ++i)
+        {
+            if(!params.push(false))
+                return fail_too_large();
+        }
+        return symbols.push(symbol) || fail_too_large();
+    }
+
+    constexpr void report_unexpected(NonTerminal symbol, size_t offset)
+    {
+        const auto& info = grammar::nonterminals[static_cast<size_t>(symbol)];
+        fail(info.diag, offset);
+        this->result.expected = info.expected;
+    }
+
+    constexpr bool run_action(ParseAction action);
+
+    /// Checks a call against its function and pushes its value.
+    constexpr bool check_call(const Value& name, size_t first_arg, size_t rparen);
+
+private:
+    std::string_view source;
+    size_t current_pos = 0;
+    StaticCheckResult result;
+
+    FixedStack<Value, max_values> values;
+    FixedStack<Symbol, max_symbols> symbols;
+    FixedStack<bool, max_params> params; //< whether each parameter is an array
+    FixedStack<Scope, max_scopes> scopes;
+    FixedStack<Arg, max_args> args;      //< arguments of the calls being parsed
+
+    size_t num_decls = 0;        //< top-level declarations so far
+    bool last_decl_is_main = false;
+    bool is_current_fun_void = true;
+    FunAttributes current_fun_attributes = FunAttributes::None;
+};
+
+constexpr auto StaticChecker::check_program() -> StaticCheckResult
+{
+    FixedStack<GrammarSymbol, max_parse_stack> parse_stack;
+    Value peek_word;
+    bool derived_var = false;
+
+    if(!enter_scope(false)
+       || !make_builtin("println", ExprType::Void, 1)
+       || !make_builtin("input", ExprType::Int, 0)
+       || !make_builtin("alloc", ExprType::Array, 1)
+       || !next_word(peek_word))
+    {
+        return result;
+    }
+
+    parse_stack.push(grammar::N(NonTerminal::Program));
+    while(!parse_stack.empty())
+    {
+        const auto symbol = parse_stack.pop();
+        switch(symbol.kind)
+        {
+            case GrammarSymbol::Terminal:
+            case GrammarSymbol::TerminalWord:
+            {
+                if(peek_word.category != symbol.category())
+                {
+                    fail(Diag::parser_expected_token, peek_word.begin);
+                    this->result.expected = symbol.category();
+                    return result;
+                }
+
+                if(symbol.kind == GrammarSymbol::TerminalWord && !push(peek_word))
+                    return result;
+                if(!next_word(peek_word))
+                    return result;
+
+                // Only a variable right before an assignment is an lvalue,
+                // thus not `(a) = 1`.
+                derived_var = false;
+                break;
+            }
+
+            case GrammarSymbol::NonTerminal:
+            {
+                const auto prod = parse_table.predict[symbol.value][static_cast<size_t>(peek_word.category)];
+                if(prod == ParseTable::no_production)
+                {
+                    report_unexpected(symbol.nonterminal(), peek_word.begin);
+                    return result;
+                }
+
+                const auto& production = grammar::productions[prod];
+                for(size_t i = production.size; i > 0; --i)
+                {
+                    if(!parse_stack.push(production.rhs[i - 1]))
+                    {
+                        fail_too_large();
+                        return result;
+                    }
+                }
+                break;
+            }
+
+            case GrammarSymbol::Action:
+            {
+                const auto action = symbol.action();
+                if(action == ParseAction::CheckAssign && !derived_var)
+                {
+                    fail(Diag::parser_expected_lvalue, peek_word.begin);
+                    return result;
+                }
+
+                if(!run_action(action))
+                    return result;
+
+                derived_var = (action == ParseAction::Var
+                               || action == ParseAction::IndexedVar
+                               || action == ParseAction::MatrixVar);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+constexpr bool StaticChecker::run_action(ParseAction action)
+{
+    switch(action)
+    {
+        case ParseAction::ProgramStart:
+        case ParseAction::CompoundStart:
+        case ParseAction::StatementsStart:
+        case ParseAction::NullStmt:
+        {
+            return push(Value());
+        }
+
+        case ParseAction::ProgramEnd:
+        {
+            if(num_decls == 0)
+                return fail(Diag::sema_empty_program, 0);
+            if(!last_decl_is_main)
+                return fail(Diag::sema_last_decl_not_main, 0);
+            return true;
+        }
+
+        case ParseAction::TopLevelDecl:
+        {
+            const auto& symbol = symbols[values.pop().index];
+            ++this->num_decls;
+            this->last_decl_is_main = (symbol.kind == SymbolKind::Fun
+                                       && symbol.is_void
+                                       && symbol.name == "main"
+                                       && symbol.num_params == 0);
+            return true;
+        }
+
+        case ParseAction::VarDecl:
+        case ParseAction::ArrayVarDecl:
+        case ParseAction::MatrixVarDecl:
+        case ParseAction::ScalarParam:
+        case ParseAction::ArrayParam:
+        {
+            int64_t row_bytes = 4;
+            int64_t num_rows = 1;
+            if(action == ParseAction::MatrixVarDecl)
+                row_bytes *= number(values.pop());
+            if(action == ParseAction::ArrayVarDecl || action == ParseAction::MatrixVarDecl)
+                num_rows = number(values.pop());
+
+            const auto id = values.pop();
+            const auto type = values.pop();
+            const bool is_array = (action == ParseAction::ArrayVarDecl
+                                   || action == ParseAction::ArrayParam);
+            auto kind = (is_array ? SymbolKind::Array : SymbolKind::Var);
+            if(action == ParseAction::MatrixVarDecl)
+                kind = SymbolKind::Matrix;
+            if(!insert(id, kind, false))
+                return false;
+            if(type.category == Category::Void)
+                return fail(Diag::sema_var_cannot_be_void, type.begin);
+            if(row_bytes > ASTVarDecl::max_bytes || num_rows * row_bytes > ASTVarDecl::max_bytes)
+                return fail(Diag::sema_array_too_large, id.begin);
+
+            if(action == ParseAction::ScalarParam || action == ParseAction::ArrayParam)
+            {
+                ++symbols[values.top().index].num_params;
+                return params.push(is_array) || fail_too_large();
+            }
+
+            Value decl;
+            decl.index = symbols.size() - 1;
+            return push(decl);
+        }
+
+        case ParseAction::FunDeclStart:
+        {
+            const auto id = values.pop();
+            const auto retn = values.pop();
+            const bool is_void = (retn.category == Category::Void);
+            if(!insert(id, SymbolKind::Fun, is_void))
+                return false;
+
+            this->is_current_fun_void = is_void;
+            this->current_fun_attributes = FunAttributes::None;
+            Value decl;
+            decl.index = symbols.size() - 1;
+            return push(decl);
+        }
+
+        case ParseAction::FunAttribute:
+        {
+            const auto id = values.pop();
+            const auto attr = find_fun_attribute(lexeme(id));
+            if(!attr)
+                return fail(Diag::sema_unknown_attribute, id.begin);
+            if(are_conflicting(current_fun_attributes | attr))
+                return fail(Diag::sema_conflicting_attributes, id.begin);
+            this->current_fun_attributes = current_fun_attributes | attr;
+            return true;
+        }
+
+        case ParseAction::FunDeclBody:
+        case ParseAction::Discard:
+        case ParseAction::AppendDecl:
+        case ParseAction::AppendStmt:
+        {
+            values.pop();
+            return true;
+        }
+
+        case ParseAction::FunDeclEnd:
+        {
+            this->is_current_fun_void = true;
+            return true;
+        }
+
+        case ParseAction::EnterParamsScope:
+        case ParseAction::EnterFunScope:
+        case ParseAction::EnterScope:
+        {
+            return enter_scope(action == ParseAction::EnterParamsScope);
+        }
+
+        case ParseAction::LeaveScope:
+        {
+            leave_scope();
+            return true;
+        }
+
+        case ParseAction::CompoundStmt:
+        {
+            values.pop();
+            values.pop();
+            return push(Value());
+        }
+
+        case ParseAction::ExprStmt:
+        {
+            const auto expr = values.pop();
+            if(expr.type == ExprType::Array)
+                return fail(Diag::sema_array_statement, expr.begin);
+            return push(Value());
+        }
+
+        case ParseAction::SelectionStmt:
+        case ParseAction::SelectionElseStmt:
+        case ParseAction::IterationStmt:
+        {
+            if(action == ParseAction::SelectionElseStmt)
+                values.pop();
+            values.pop();
+            const auto expr = values.pop();
+            if(expr.type != ExprType::Int)
+                return fail(Diag::sema_expr_not_boolean, expr.begin);
+            return push(Value());
+        }
+
+        case ParseAction::ReturnStmt:
+        case ParseAction::ReturnValueStmt:
+        {
+            if(action == ParseAction::ReturnValueStmt)
+            {
+                const auto expr = values.pop();
+                const auto return_word = values.pop();
+                if(is_current_fun_void)
+                    return fail(Diag::sema_void_fun_returning_value, return_word.begin);
+                if(expr.type != ExprType::Int)
+                    return fail(Diag::sema_incompatible_return_type, expr.begin);
+            }
+            else
+            {
+                const auto return_word = values.pop();
+                if(!is_current_fun_void)
+                    return fail(Diag::sema_int_fun_not_returning_value, return_word.begin);
+            }
+            return push(Value());
+        }
+
+        case ParseAction::CheckAssign:
+        {
+            // The parser checks this one by itself.
+            return true;
+        }
+
+        case ParseAction::Assign:
+        case ParseAction::BinaryExpr:
+        {
+            const auto rhs = values.pop();
+            const auto op = values.pop();
+            const auto lhs = values.pop();
+            if(lhs.type != ExprType::Int || rhs.type != ExprType::Int)
+            {
+                return fail(action == ParseAction::Assign ? Diag::sema_assignment_type_error
+                                                          : Diag::sema_binary_expr_type_error,
+                            op.begin);
+            }
+            return push_expr(ExprType::Int, lhs.begin, rhs.end);
+        }
+
+        case ParseAction::PreIncrement:
+        case ParseAction::PostIncrement:
+        {
+            const bool is_postfix = (action == ParseAction::PostIncrement);
+            const auto first = values.pop();
+            const auto second = values.pop();
+            const auto& var = is_postfix ? second : first;
+            const auto& op = is_postfix ? first : second;
+            if(var.type != ExprType::Int)
+                return fail(Diag::sema_assignment_type_error, op.begin);
+            return push_expr(ExprType::Int, second.begin, first.end);
+        }
+
+        case ParseAction::Number:
+        {
+            const auto word = values.pop();
+            int64_t number = 0;
+            for(auto c : lexeme(word))
+            {
+                number = number * 10 + (c - '0');
+                if(number > INT32_MAX)
+                    return fail(Diag::parser_number_too_big, word.begin);
+            }
+            return push_expr(ExprType::Int, word.begin, word.end);
+        }
+
+        case ParseAction::Var:
+        case ParseAction::IndexedVar:
+        case ParseAction::MatrixVar:
+        {
+            Value index, col_index;
+            const bool has_col_index = (action == ParseAction::MatrixVar);
+            const bool has_index = (action != ParseAction::Var);
+            if(has_col_index)
+                col_index = values.pop();
+            if(has_index)
+                index = values.pop();
+            const auto id = values.pop();
+
+            const auto decl = lookup(lexeme(id));
+            if(decl == max_symbols)
+                return fail(Diag::sema_undeclared_identifier, id.begin);
+
+            const auto kind = symbols[decl].kind;
+            if(kind == SymbolKind::Fun)
+                return fail(Diag::sema_var_is_not_var, id.begin);
+            if(has_index && index.type != ExprType::Int)
+                return fail(Diag::sema_index_is_not_int, index.begin);
+            if(has_col_index && col_index.type != ExprType::Int)
+                return fail(Diag::sema_index_is_not_int, col_index.begin);
+            if(has_index && kind == SymbolKind::Var)
+                return fail(Diag::sema_index_is_not_int, index.begin);
+            if(has_col_index && kind != SymbolKind::Matrix)
+                return fail(Diag::sema_index_is_not_int, col_index.begin);
+
+            // A two-dimensional array subscripted once is one of its rows.
+            const bool is_array = (kind == SymbolKind::Array && !has_index)
+                                  || (kind == SymbolKind::Matrix && !has_col_index);
+            return push_expr(is_array ? ExprType::Array : ExprType::Int, id.begin, id.end);
+        }
+
+        case ParseAction::CallStart:
+        {
+            Value arg_list;
+            arg_list.index = args.size();
+            return push(arg_list);
+        }
+
+        case ParseAction::AppendArg:
+        {
+            const auto expr = values.pop();
+            Arg arg;
+            arg.type = expr.type;
+            arg.begin = expr.begin;
+            return args.push(arg) || fail_too_large();
+        }
+
+        case ParseAction::Call:
+        {
+            const auto rparen = values.pop();
+            const auto first_arg = values.pop().index;
+            const auto id = values.pop();
+            return check_call(id, first_arg, rparen.begin);
+        }
+    }
+
+    return true;
+}
+
+constexpr bool StaticChecker::check_call(const Value& name, size_t first_arg, size_t rparen)
+{
+    const auto decl = lookup(lexeme(name));
+    if(decl == max_symbols)
+        return fail(Diag::sema_undeclared_identifier, name.begin);
+
+    const auto& fun = symbols[decl];
+    if(fun.kind != SymbolKind::Fun)
+        return fail(Diag::sema_fun_is_not_fun, name.begin);
+
+    const auto num_args = args.size() - first_arg;
+    for(size_t a = 0; a < num_args && a < fun.num_params; ++a)
+    {
+        const auto& arg = args[first_arg + a];
+        const bool is_arg_array = (arg.type == ExprType::Array);
+        if(arg.type == ExprType::Void || is_arg_array != params[fun.first_param + a])
+            return fail(Diag::sema_arg_type_mismatch, arg.begin);
+    }
+
+    if(num_args < fun.num_params)
+        return fail(Diag::sema_arg_too_few_params, name.begin);
+    if(num_args > fun.num_params)
+        return fail(Diag::sema_arg_too_many_params, name.begin);
+
+    const auto type = (fun.is_void ? ExprType::Void
+                       : fun.is_array ? ExprType::Array
+                                      : ExprType::Int);
+    this->args.resize(first_arg);
+    return push_expr(type, name.begin, rparen);
+}
+
+/// Lexes, parses and type-checks a program, in a constant expression if
+/// need be.
+constexpr auto check_program(std::string_view source) -> StaticCheckResult
+{
+    return StaticChecker(source).check_program();
+}
+}
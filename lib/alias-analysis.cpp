@@ -0,0 +1,258 @@
+#include <cminus/alias-analysis.hpp>
+#include <cminus/ast-visitor.hpp>
+
+namespace
+{
+using namespace cminus;
+
+/// Collects the memory accesses and calls made directly by a function.
+class AccessCollector : public ASTVisitor
+{
+public:
+    struct Access
+    {
+        ASTVarDecl* var;
+        ModRef mod_ref;
+    };
+
+    void visit_var_decl(ASTVarDecl& decl) override
+    {
+        if(decl.is_array())
+            this->local_arrays.push_back(&decl);
+    }
+
+    void visit_var_expr(ASTVarRef& var_ref) override
+    {
+        // Naming an array or a row (e.g. to pass it along) does not access it.
+        if(var_ref.type() != ExprType::Array)
+            this->accesses.push_back(Access{var_ref.get_decl().get(), ModRef::Ref});
+        walk_var_expr(var_ref);
+    }
+
+    void visit_call_expr(ASTFunCall& call) override
+    {
+        this->calls.push_back(&call);
+        if(call.type() == ExprType::Array)
+            this->allocations.push_back(&call);
+        walk_call_expr(call);
+    }
+
+    void visit_binary_expr(ASTBinaryExpr& expr) override
+    {
+        if(expr.get_operation() != ASTBinaryExpr::Operation::Assign)
+        {
+            walk_binary_expr(expr);
+            return;
+        }
+
+        auto var_ref = expr.get_left()->as_var_expr();
+        this->accesses.push_back(Access{var_ref->get_decl().get(), ModRef::Mod});
+        if(auto index = var_ref->get_index())
+            visit_expr(*index);
+        if(auto col_index = var_ref->get_col_index())
+            visit_expr(*col_index);
+        visit_expr(*expr.get_right());
+    }
+
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override
+    {
+        auto var_ref = expr.get_var();
+        this->accesses.push_back(Access{var_ref->get_decl().get(), ModRef::Mod});
+        walk_compound_assign_expr(expr);
+    }
+
+public:
+    std::vector<ASTVarDecl*> local_arrays;
+    std::vector<Access> accesses;
+    std::vector<ASTFunCall*> calls;
+    std::vector<ASTFunCall*> allocations;
+};
+}
+
+namespace cminus
+{
+AliasAnalysis::AliasAnalysis(ASTProgram& program)
+{
+    std::vector<std::pair<ASTFunDecl*, AccessCollector>> funs;
+    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
+    {
+        if(auto var_decl = (*it)->as_var_decl())
+        {
+            this->globals.insert(var_decl.get());
+            this->objects.push_back(var_decl.get());
+        }
+        else if(auto fun_decl = (*it)->as_fun_decl())
+        {
+            AccessCollector collector;
+            collector.visit_compound_stmt(*fun_decl->get_body());
+            for(auto local_array : collector.local_arrays)
+                this->objects.push_back(local_array);
+            funs.emplace_back(fun_decl.get(), std::move(collector));
+        }
+    }
+
+    // Globals and local arrays refer to their own object.
+    for(size_t i = 0; i < objects.size(); ++i)
+        this->var_points_to[objects[i]].insert(i);
+
+    // So does the memory allocated by each call to a builtin.
+    auto num_objects = objects.size();
+    for(auto& [fun, collector] : funs)
+    {
+        for(auto call : collector.allocations)
+            this->call_points_to[call].insert(num_objects++);
+    }
+
+    // Parameters of functions that are never called may refer to anything.
+    std::unordered_set<const ASTFunDecl*> callees;
+    for(auto& [fun, collector] : funs)
+    {
+        for(auto call : collector.calls)
+            callees.insert(call->get_decl().get());
+    }
+
+    for(auto& [fun, collector] : funs)
+    {
+        for(auto it = fun->parm_begin(); it != fun->parm_end(); ++it)
+        {
+            if(!(*it)->is_array())
+                continue;
+
+            auto& param_set = this->var_points_to[it->get()];
+            if(!callees.count(fun))
+            {
+                for(size_t i = 0; i < num_objects; ++i)
+                    param_set.insert(i);
+            }
+        }
+    }
+
+    // Array parameters refer to whatever is bound to them in call sites.
+    for(bool changed = true; changed;)
+    {
+        changed = false;
+        for(auto& [fun, collector] : funs)
+        {
+            for(auto call : collector.calls)
+            {
+                auto callee = call->get_decl();
+                size_t i = 0;
+                for(auto it = call->arg_begin(); it != call->arg_end(); ++it, ++i)
+                {
+                    auto param = callee->get_param(i);
+                    if(!param->is_array())
+                        continue;
+
+                    auto& arg = **it;
+                    assert(arg.type() == ExprType::Array);
+                    changed |= var_points_to[param.get()].merge(points_to(arg));
+                }
+            }
+        }
+    }
+
+    // Each function accesses what it accesses directly...
+    for(auto& [fun, collector] : funs)
+    {
+        auto& summary = this->summaries[fun];
+        for(const auto& access : collector.accesses)
+        {
+            auto& dest = (!(access.mod_ref & ModRef::Mod) ? summary.ref : summary.mod);
+            dest.merge(points_to(*access.var));
+        }
+    }
+
+    // ...and whatever the functions it calls access.
+    for(bool changed = true; changed;)
+    {
+        changed = false;
+        for(auto& [fun, collector] : funs)
+        {
+            auto& summary = this->summaries[fun];
+            for(auto call : collector.calls)
+            {
+                auto it = summaries.find(call->get_decl().get());
+                if(it == summaries.end() || &it->second == &summary)
+                    continue;
+
+                if(!call->get_decl()->has_attribute(FunAttributes::Pure))
+                    changed |= summary.mod.merge(it->second.mod);
+                changed |= summary.ref.merge(it->second.ref);
+            }
+        }
+    }
+}
+
+bool AliasAnalysis::may_alias(const ASTVarDecl& lhs, const ASTVarDecl& rhs) const
+{
+    return &lhs == &rhs || points_to(lhs).intersects(points_to(rhs));
+}
+
+auto AliasAnalysis::get_mod_ref(ASTFunCall& call, const ASTVarDecl& var) const
+        -> ModRef
+{
+    return get_mod_ref(*call.get_decl(), var);
+}
+
+auto AliasAnalysis::get_mod_ref(const ASTFunDecl& fun, const ASTVarDecl& var) const
+        -> ModRef
+{
+    // Builtins do not access any variable.
+    auto it = summaries.find(&fun);
+    if(it == summaries.end())
+        return ModRef::None;
+
+    const auto& var_set = points_to(var);
+    auto result = ModRef::None;
+    if(!fun.has_attribute(FunAttributes::Pure) && it->second.mod.intersects(var_set))
+        result = result | ModRef::Mod;
+    if(it->second.ref.intersects(var_set))
+        result = result | ModRef::Ref;
+    return result;
+}
+
+auto AliasAnalysis::points_to(const ASTVarDecl& var) const -> const ObjectSet&
+{
+    auto it = var_points_to.find(&var);
+    return it != var_points_to.end() ? it->second : empty_set;
+}
+
+auto AliasAnalysis::points_to(ASTExpr& array) const -> const ObjectSet&
+{
+    if(auto call = array.as_call_expr())
+        return call_points_to.at(call.get());
+    return points_to(*array.as_var_expr()->get_decl());
+}
+
+bool AliasAnalysis::ObjectSet::intersects(const ObjectSet& other) const
+{
+    const auto size = std::min(bits.size(), other.bits.size());
+    for(size_t i = 0; i < size; ++i)
+    {
+        if(bits[i] && other.bits[i])
+            return true;
+    }
+    return false;
+}
+
+void AliasAnalysis::ObjectSet::insert(size_t object)
+{
+    if(object >= bits.size())
+        this->bits.resize(object + 1);
+    this->bits[object] = true;
+}
+
+bool AliasAnalysis::ObjectSet::merge(const ObjectSet& other)
+{
+    bool changed = false;
+    for(size_t i = 0; i < other.bits.size(); ++i)
+    {
+        if(other.bits[i] && !contains(i))
+        {
+            insert(i);
+            changed = true;
+        }
+    }
+    return changed;
+}
+}
@@ -1,186 +1,217 @@
+#include <algorithm>
 #include <cminus/ast-codegen-visitor.hpp>
+#include <cminus/cfg.hpp>
+#include <cminus/utility/contracts.hpp>
 
 constexpr auto REG_V0 = 2;
+constexpr auto REG_V1 = 3;
 constexpr auto REG_T0 = 8;
 constexpr auto REG_A0 = 4;
+constexpr auto REG_S0 = 16;
+constexpr auto REG_FP = 30;
 constexpr auto REG_RA = 31;
 
 namespace
 {
 using namespace cminus;
 
-/// This is a stack frame allocator.
-///
-/// For each function definition, it calculates the suitable size (and offsets)
-/// for its activation record.
-///
-/// It also calculates the offsets in the frame for each local variable in the
-/// function.
-///
-/// The activation record of a function generated by us is composed by six blocks:
-///
-///     $sp ->
-///           | output | temporaries | saved | local | input         |
-///           | callee stack frame                    | caller frame |
-///
-/// + The input block contains the arguments to the function. The first four
-///   arguments are in the callee stack frame while the rest is in the caller's.
-/// + The local block contains automatic variables.
-/// + The saved block is used for saving the procedure return address ($ra).
-/// + The temporaries block holds data used for computing nested expressions.
-///   This is essentially a stack where the stack top pointer is known by the
-///   code generator (so we don't need an additional register for that).
-/// + The output block is a space reserved for inputs of functions called by
-///   the current procedure.
-///
-class FrameAllocatorVisitor : public ASTVisitor
+/// Finds whether a statement calls a function given the `cold` attribute,
+/// in which case the statement is assumed to be rarely executed.
+class ColdCallFinder : public ASTVisitor
 {
 public:
-    using FrameInfo = ASTCodegenVisitor::FrameInfo;
-
-    explicit FrameAllocatorVisitor(
-            std::unordered_map<ASTFunDecl*, FrameInfo>& out_frames,
-            std::unordered_map<ASTVarDecl*, int32_t>& out_local_pos) :
-        frames(out_frames),
-        local_pos(out_local_pos)
+    void visit_call_expr(ASTFunCall& call) override
     {
+        this->found |= call.get_decl()->has_attribute(FunAttributes::Cold);
+        walk_call_expr(call);
     }
 
-    void visit_fun_decl(ASTFunDecl& decl) override
+public:
+    bool found = false;
+};
+
+bool calls_cold_function(ASTStmt& stmt)
+{
+    ColdCallFinder finder;
+    finder.visit_stmt(stmt);
+    return finder.found;
+}
+
+/// Finds whether an expression calls any function.
+class CallFinder : public ASTVisitor
+{
+public:
+    void visit_call_expr(ASTFunCall&) override
     {
-        this->frame = FrameInfo{};
-        this->frame.saved_size = 4; // $ra
+        this->found = true;
+    }
 
-        // Calculate the size of the other blocks by recursing into the body.
-        this->inside_function = true;
-        visit_compound_stmt(*decl.get_body());
-        this->inside_function = false;
+public:
+    bool found = false;
+};
 
-        // Calculate size of input block and assign offset to param vars.
-        // Must be after recursing into the body so we have the size of
-        // the local block already computed.
-        for(auto it = decl.parm_begin(); it != decl.parm_end(); ++it)
-        {
-            auto var_decl = static_cast<ASTVarDecl*>((*it).get());
-            this->local_pos[var_decl] = frame.local_size + frame.input_size;
-            this->frame.input_size = std::min(16, frame.input_size + 4);
-        }
+bool makes_call(ASTExpr& expr)
+{
+    CallFinder finder;
+    finder.visit_expr(expr);
+    return finder.found;
+}
+}
 
-        this->frames[&decl] = std::move(this->frame);
-    }
+// The activation record of a function generated by us is composed by six blocks:
+//
+//     $sp ->
+//           | output | temporaries | saved | local | input         |
+//           | callee stack frame                    | caller frame |
+//
+// + The input block contains the arguments to the function. The first four
+//   arguments are in the callee stack frame while the rest is in the caller's.
+// + The local block contains automatic variables.
+// + The saved block is used for saving the procedure return address ($ra),
+//   followed by the frame pointer ($fp) of the caller if one is kept, and by
+//   the registers holding promoted globals.
+// + The temporaries block holds data used for computing nested expressions.
+//   This is essentially a stack where the stack top pointer is known by the
+//   code generator (so we don't need an additional register for that).
+// + The output block is a space reserved for inputs of functions called by
+//   the current procedure.
+//
+// The size of each block is found while the function is generated, so every
+// offset into the frame is filled in once the function is complete.
 
-    void visit_compound_stmt(ASTCompoundStmt& stmt) override
-    {
-        const auto outer_local_pos = current_local_pos;
-        walk_compound_stmt(stmt);
-        this->frame.local_size = std::max(frame.local_size, current_local_pos);
-        this->current_local_pos = outer_local_pos;
-    }
+namespace cminus
+{
+void ASTCodegenVisitor::visit_program(ASTProgram& program)
+{
+    this->source_table = &program.get_source_table();
 
-    void visit_var_decl(ASTVarDecl& decl) override
+    dest += ".data\n";
+    dest += ".align 2\n";
+    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
     {
-        if(inside_function)
-        {
-            auto num_elms = (!decl.is_array() ? 1 : decl.get_array_size()->get_value());
-            this->local_pos[&decl] = current_local_pos;
-            this->current_local_pos += 4 * num_elms;
-        }
+        if(auto var_decl = (*it)->as_var_decl())
+            visit_var_decl(*var_decl);
     }
 
-    void visit_call_expr(ASTFunCall& expr) override
+    const auto funs = layout_functions(program);
+
+    if(options.profile)
+        emit_profile_tables(funs);
+
+    if(options.optimize)
+        this->aliases.emplace(program);
+
+    dest += "\n.text\n";
+    for(auto fun_decl : funs)
     {
-        auto num_parms = static_cast<int32_t>(expr.get_decl()->get_num_params());
-        if(num_parms > 4)
+        if(budget && budget->check_output(dest.size()))
+            break;
+
+        if(options.optimize)
         {
-            const int32_t requires_output = 4 * (num_parms - 4);
-            this->frame.output_size = std::max(frame.output_size, requires_output);
+            const auto cfg = CFG::build(*fun_decl);
+            this->constants.emplace(*fun_decl, cfg);
+            this->elements.emplace(cfg, *aliases);
+            this->promotions.emplace(*fun_decl, *aliases);
+            this->rows.emplace(*fun_decl, *aliases);
         }
 
-        walk_call_expr(expr);
+        visit_fun_decl(*fun_decl);
+        ++this->function_index;
     }
 
-    void visit_binary_expr(ASTBinaryExpr& expr) override
-    {
-        // binary expressions need 4 bytes of temporary space to be evaluated.
-        const auto temp_bytes = 4;
-        temp_enter(temp_bytes);
-        walk_binary_expr(expr);
-        temp_leave(temp_bytes);
-    }
-
-    void visit_var_expr(ASTVarRef& var_ref) override
-    {
-        // variable references also need 4 bytes of temporary space sometimes.
-        const auto temp_bytes = var_ref.get_index() ? 4 : 0;
-        temp_enter(temp_bytes);
-        walk_var_expr(var_ref);
-        temp_leave(temp_bytes);
-    }
+    if(options.profile)
+        dest += "__crt_prof_text_end:\n";
 
-    /// Emulates the push of something into the temporary space.
-    void temp_enter(uint32_t bytes)
-    {
-        this->current_temp_pos += bytes;
-    }
+    // Ends the range of the last function.
+    this->current_fun = nullptr;
+    mark_source(nullptr);
+}
 
-    /// Emulates the pop of something from the temporary space.
-    void temp_leave(uint32_t bytes)
+auto ASTCodegenVisitor::layout_functions(ASTProgram& program) -> std::vector<ASTFunDecl*>
+{
+    std::vector<ASTFunDecl*> funs;
+    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
     {
-        this->frame.temp_size = std::max(frame.temp_size, current_temp_pos);
-        this->current_temp_pos -= bytes;
+        if(auto fun_decl = (*it)->as_fun_decl())
+            funs.push_back(fun_decl.get());
     }
 
-private:
-    // Output structures.
-    std::unordered_map<ASTFunDecl*, FrameInfo>& frames;
-    std::unordered_map<ASTVarDecl*, int32_t>& local_pos;
-
-    // Auxiliar variables for computing the above structures.
-    FrameInfo frame;
-    bool inside_function = false;
-    int32_t current_local_pos = 0;
-    int32_t current_temp_pos = 0;
-};
+    // Hot functions go first and cold ones last, so that the code executed
+    // often is packed together.
+    auto rank = [](const ASTFunDecl* fun) {
+        if(fun->has_attribute(FunAttributes::Hot))
+            return 0;
+        return fun->has_attribute(FunAttributes::Cold) ? 2 : 1;
+    };
+    std::stable_sort(funs.begin(), funs.end(), [&](const ASTFunDecl* lhs, const ASTFunDecl* rhs) {
+        return rank(lhs) < rank(rhs);
+    });
+    return funs;
 }
 
-namespace cminus
-{
-void ASTCodegenVisitor::visit_program(ASTProgram& program)
+void ASTCodegenVisitor::emit_profile_tables(const std::vector<ASTFunDecl*>& funs)
 {
-    dest += ".data\n";
-    dest += ".align 2\n";
-    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
+    dest += "__crt_prof_nfuns: .word ";
+    dest += std::to_string(funs.size());
+    dest += '\n';
+
+    // Functions are laid out in order, so each one ends where the next
+    // one begins.
+    dest += "__crt_prof_funs:\n";
+    for(auto fun : funs)
     {
-        if(auto var_decl = (*it)->as_var_decl())
-            visit_var_decl(*var_decl);
+        dest += ".word ";
+        dest += fun->get_name();
+        dest += '\n';
+    }
+    dest += ".word __crt_prof_text_end\n";
+
+    // Calls from outside the program are attributed to an extra caller.
+    dest += "__crt_prof_names:\n";
+    for(size_t i = 0; i < funs.size(); ++i)
+    {
+        dest += ".word __crt_prof_name";
+        dest += std::to_string(i);
+        dest += '\n';
     }
+    dest += ".word __crt_prof_spontaneous\n";
 
-    auto frame_allocator = FrameAllocatorVisitor(this->frames, this->local_pos);
+    // The call counts, indexed by caller and then callee.
+    dest += "__crt_prof_arcs: .space ";
+    dest += std::to_string(4 * (funs.size() + 1) * funs.size());
+    dest += '\n';
 
-    dest += "\n.text\n";
-    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
+    for(size_t i = 0; i < funs.size(); ++i)
     {
-        if(auto fun_decl = (*it)->as_fun_decl())
-        {
-            frame_allocator.visit_fun_decl(*fun_decl);
-            visit_fun_decl(*fun_decl);
-        }
+        dest += "__crt_prof_name";
+        dest += std::to_string(i);
+        dest += ": .asciiz \"";
+        dest += funs[i]->get_name();
+        dest += "\"\n";
     }
+    dest += ".align 2\n";
 }
 
 void ASTCodegenVisitor::visit_var_decl(ASTVarDecl& decl)
 {
+    const auto num_bytes = decl.get_num_bytes();
     if(!inside_function)
     {
         dest += decl.get_name();
         dest += ": ";
 
-        auto num_elms = (!decl.is_array() ? 1 : decl.get_array_size()->get_value());
         dest += ".space ";
-        dest += std::to_string(4 * num_elms);
+        dest += std::to_string(num_bytes);
 
         dest += '\n';
     }
+    else
+    {
+        this->local_pos[&decl] = FrameSlot{FrameSlot::Local, current_local_pos};
+        this->current_local_pos += static_cast<int32_t>(num_bytes);
+        this->current_frame.local_size = std::max(current_frame.local_size, current_local_pos);
+    }
 }
 
 void ASTCodegenVisitor::visit_parm_decl(ASTParmVarDecl& decl)
@@ -190,55 +221,100 @@ void ASTCodegenVisitor::visit_parm_decl(ASTParmVarDecl& decl)
 
 void ASTCodegenVisitor::visit_fun_decl(ASTFunDecl& decl)
 {
-    this->current_frame = this->frames[&decl];
-    auto frame_size_s = std::to_string(current_frame.total_size());
+    const auto num_sregs = promotions ? promotions->get_num_regs() : 0;
+    const auto num_params = static_cast<int32_t>(decl.get_num_params());
+
+    this->current_frame = FrameInfo{};
+    this->current_frame.saved_size = (options.frame_pointer ? 8 : 4) + 4 * num_sregs;
+    this->current_frame.input_size = std::min(16, 4 * num_params);
+    this->current_local_pos = 0;
+    this->frame_fixups.clear();
+    this->function_begin = dest.size();
 
-    const auto RA_OFFSET = current_frame.saved_offset(0);
+    const auto FRAME_SIZE = FrameSlot{FrameSlot::End, 0};
+    const auto RA_SLOT = FrameSlot{FrameSlot::Saved, 0};
+    const auto FP_SLOT = FrameSlot{FrameSlot::Saved, 4};
+    const auto SREGS_SLOT = FrameSlot{FrameSlot::Saved, options.frame_pointer ? 8 : 4};
 
     this->inside_function = true;
     this->function_label_goto_ob = -1;
+    this->current_fun = &decl;
 
-    /*
-    dest += "# ";
-    dest += std::to_string(current_frame.output_size);
-    dest += ' ';
-    dest += std::to_string(current_frame.temp_size);
-    dest += ' ';
-    dest += std::to_string(current_frame.saved_size);
-    dest += ' ';
-    dest += std::to_string(current_frame.local_size);
-    dest += ' ';
-    dest += std::to_string(current_frame.input_size);
-    dest += '\n';
-    */
+    for(int32_t i = 0; i < num_params; ++i)
+    {
+        auto var_decl = static_cast<ASTVarDecl*>(decl.get_param(i).get());
+        this->local_pos[var_decl] = FrameSlot{FrameSlot::Input, 4 * i};
+    }
+
+    mark_source(decl.get_name().begin());
 
     dest += decl.get_name();
     dest += ":\n";
 
+    // Early returns needing no stack frame are taken before setting it up,
+    // which is mostly useful to the base cases of recursive functions.
+    this->num_frameless_guards = count_frameless_guards(decl);
+    if(num_frameless_guards != 0)
+    {
+        auto guard_it = decl.get_body()->stmt_begin();
+        for(size_t i = 0; i < num_frameless_guards; ++i, ++guard_it)
+            emit_frameless_guard(*(*guard_it)->as_selection_stmt());
+        mark_source(decl.get_name().begin());
+    }
+
     // Function prologue.
     dest += "addiu $sp, $sp, -";
-    dest += frame_size_s;
+    emit_frame_offset(FRAME_SIZE);
     dest += "\n";
-    emit_frame_sw(REG_RA, RA_OFFSET);
-    for(size_t i = 0; i < 4 && i < decl.get_num_params(); ++i)
-        emit_frame_sw(REG_A0 + i, current_frame.input_offset(4 * i));
+    emit_frame_sw(REG_RA, RA_SLOT);
+    if(options.frame_pointer)
+    {
+        emit_frame_sw(REG_FP, FP_SLOT);
+        dest += "addiu $fp, $sp, ";
+        emit_frame_offset(RA_SLOT);
+        dest += '\n';
+    }
+    for(int32_t i = 0; i < 4 && i < num_params; ++i)
+        emit_frame_sw(REG_A0 + i, FrameSlot{FrameSlot::Input, 4 * i});
+    for(int32_t i = 0; i < num_sregs; ++i)
+        emit_frame_sw(REG_S0 + i, FrameSlot{SREGS_SLOT.block, SREGS_SLOT.offset + 4 * i});
+
+    if(options.profile)
+    {
+        // The runtime finds the caller from the return address.
+        emit_move(REG_T0, REG_RA);
+        dest += "li $t1, ";
+        dest += std::to_string(function_index);
+        dest += '\n';
+        dest += "jal __crt_mcount\n";
+    }
 
     this->function_epilogue_label = next_label_id();
 
     visit_compound_stmt(*decl.get_body());
 
     // Function epilogue
+    mark_source(decl.get_name().begin());
     dest += ".L";
     dest += std::to_string(function_epilogue_label);
     dest += ":\n";
 
-    emit_frame_lw(REG_RA, RA_OFFSET);
+    if(options.profile && decl.get_name() == "main")
+        dest += "jal __crt_mcleanup\n";
+
+    for(int32_t i = 0; i < num_sregs; ++i)
+        emit_frame_lw(REG_S0 + i, FrameSlot{SREGS_SLOT.block, SREGS_SLOT.offset + 4 * i});
+    if(options.frame_pointer)
+        emit_frame_lw(REG_FP, FP_SLOT);
+    emit_frame_lw(REG_RA, RA_SLOT);
     dest += "addiu $sp, $sp, ";
-    dest += frame_size_s;
+    emit_frame_offset(FRAME_SIZE);
     dest += "\n";
 
     dest += "jr $ra\n";
 
+    emit_cold_blocks();
+
     // We need to generate this stub at the bottom of the function
     // because a normal (non-jump) MIPS instruction has too little
     // space for a big offset. The crt may be too far away.
@@ -250,6 +326,9 @@ void ASTCodegenVisitor::visit_fun_decl(ASTFunDecl& decl)
         dest += "j __crt_out_of_bounds\n";
     }
 
+    this->frames[&decl] = current_frame;
+    patch_frame_offsets();
+
     this->inside_function = false;
 }
 
@@ -260,16 +339,79 @@ void ASTCodegenVisitor::visit_null_stmt(ASTNullStmt&)
 
 void ASTCodegenVisitor::visit_compound_stmt(ASTCompoundStmt& comp_stmt)
 {
-    walk_compound_stmt(comp_stmt);
+    // Variables of sibling compound statements share the same space.
+    const auto outer_local_pos = current_local_pos;
+
+    for(auto it = comp_stmt.decl_begin(); it != comp_stmt.decl_end(); ++it)
+        visit_decl(**it);
+
+    // The frameless guards of the function were generated already.
+    auto first_stmt = comp_stmt.stmt_begin();
+    if(&comp_stmt == current_fun->get_body().get())
+        first_stmt += num_frameless_guards;
+
+    for(auto it = first_stmt; it != comp_stmt.stmt_end(); ++it)
+    {
+        if(budget && budget->check_output(dest.size()))
+            break;
+
+        // Other statements mark their own controlling expression.
+        if(auto expr = (*it)->as_expr_stmt())
+            mark_source(*expr);
+        visit_stmt(**it);
+    }
+
+    this->current_local_pos = outer_local_pos;
 }
 
 void ASTCodegenVisitor::visit_selection_stmt(ASTSelectionStmt& if_stmt)
 {
-    const auto false_label = next_label_id();
-    int32_t fi_label = -1;
+    mark_source(*if_stmt.get_cond());
+
+    // Only one of the arms is ever executed, so there is nothing to branch on.
+    if(get_constant(*if_stmt.get_cond()))
+    {
+        if(!is_unreachable(*if_stmt.get_then()))
+            visit_stmt(*if_stmt.get_then());
+        else if(if_stmt.get_else())
+            visit_stmt(*if_stmt.get_else());
+        return;
+    }
 
     visit_expr(*if_stmt.get_cond());
 
+    // An arm calling a cold function is laid out after the function, so
+    // that the likely arm falls through without any jump.
+    const bool is_cold_then = options.optimize && calls_cold_function(*if_stmt.get_then());
+    const bool is_cold_else = options.optimize && if_stmt.get_else()
+                              && calls_cold_function(*if_stmt.get_else());
+    if(is_cold_then != is_cold_else)
+    {
+        const auto cold_label = next_label_id();
+        const auto fi_label = next_label_id();
+        auto cold_stmt = is_cold_then ? if_stmt.get_then() : if_stmt.get_else();
+        auto likely_stmt = is_cold_then ? if_stmt.get_else() : if_stmt.get_then();
+
+        dest += is_cold_then ? "bne" : "beq";
+        dest += " $v0, $0, .L";
+        dest += std::to_string(cold_label);
+        dest += '\n';
+
+        if(likely_stmt)
+            visit_stmt(*likely_stmt);
+
+        dest += ".L";
+        dest += std::to_string(fi_label);
+        dest += ":\n";
+
+        this->cold_blocks.push_back(ColdBlock{cold_stmt.get(), cold_label, fi_label,
+                                              active_promotions, current_local_pos});
+        return;
+    }
+
+    const auto false_label = next_label_id();
+    int32_t fi_label = -1;
+
     dest += "beq $v0, $0, .L";
     dest += std::to_string(false_label);
     dest += '\n';
@@ -301,34 +443,162 @@ void ASTCodegenVisitor::visit_selection_stmt(ASTSelectionStmt& if_stmt)
 
 void ASTCodegenVisitor::visit_iteration_stmt(ASTIterationStmt& while_stmt)
 {
+    if(is_unreachable(*while_stmt.get_body()))
+        return;
+
+    // The condition of an infinite loop needs not to be tested.
+    const bool is_infinite = get_constant(*while_stmt.get_cond()).has_value();
+
     auto const if_label = next_label_id();
     auto const fi_label = next_label_id();
 
-    dest += ".L";
-    dest += std::to_string(if_label);
-    dest += ":\n";
+    mark_source(*while_stmt.get_cond());
 
-    visit_expr(*while_stmt.get_cond());
+    const auto outer_size = active_promotions.size();
+    if(promotions)
+    {
+        for(const auto& global : promotions->get_promoted(while_stmt))
+        {
+            dest += "lw $";
+            dest += regname(global.reg);
+            dest += ", ";
+            dest += global.var->get_name();
+            dest += '\n';
+            this->active_promotions.push_back(global);
+        }
+    }
 
-    dest += "beq $v0, $0, .L";
-    dest += std::to_string(fi_label);
-    dest += '\n';
+    const auto outer_local_pos = current_local_pos;
+    if(rows)
+    {
+        for(const auto& row : rows->get_hoisted(while_stmt))
+        {
+            const auto row_slot = FrameSlot{FrameSlot::Local, current_local_pos};
+            this->current_local_pos += 4;
+            this->current_frame.local_size = std::max(current_frame.local_size, current_local_pos);
+            this->row_slots[row.id] = row_slot;
+
+            const auto temp_bytes = 4;
+            const auto temp_pos = temp_alloc(temp_bytes);
+            const auto skip_label = next_label_id();
+
+            load_base_address(*row.array);
+            emit_frame_sw(REG_V0, temp_pos);
+            visit_expr(*row.index);
+
+            // The loop may not access the row at all, thus a negative
+            // subscript is kept as is and only goes out of bounds when an
+            // element is accessed through it.
+            dest += "bltz $v0, .L";
+            dest += std::to_string(skip_label);
+            dest += '\n';
+
+            emit_scale(static_cast<int32_t>(row.array->get_row_bytes()));
+            emit_frame_lw(REG_T0, temp_pos);
+            dest += "addu $v0, $t0, $v0\n";
 
-    visit_stmt(*while_stmt.get_body());
+            dest += ".L";
+            dest += std::to_string(skip_label);
+            dest += ":\n";
+            emit_frame_sw(REG_V0, row_slot);
 
-    dest += "j .L";
-    dest += std::to_string(if_label);
-    dest += '\n';
+            temp_free(temp_pos, temp_bytes);
+        }
+    }
 
-    dest += ".L";
-    dest += std::to_string(fi_label);
-    dest += ":\n";
+    if(options.optimize && !is_infinite)
+    {
+        // The condition is tested at the bottom, so that each iteration
+        // takes a single branch back to the top of the body.
+        const auto cond_label = if_label;
+        const auto body_label = fi_label;
+
+        dest += "j .L";
+        dest += std::to_string(cond_label);
+        dest += '\n';
+
+        dest += ".L";
+        dest += std::to_string(body_label);
+        dest += ":\n";
+        visit_stmt(*while_stmt.get_body());
+
+        mark_source(*while_stmt.get_cond());
+        dest += ".L";
+        dest += std::to_string(cond_label);
+        dest += ":\n";
+        visit_expr(*while_stmt.get_cond());
+
+        dest += "bne $v0, $0, .L";
+        dest += std::to_string(body_label);
+        dest += '\n';
+    }
+    else
+    {
+        dest += ".L";
+        dest += std::to_string(if_label);
+        dest += ":\n";
+        if(!is_infinite)
+        {
+            visit_expr(*while_stmt.get_cond());
+
+            dest += "beq $v0, $0, .L";
+            dest += std::to_string(fi_label);
+            dest += '\n';
+        }
+
+        visit_stmt(*while_stmt.get_body());
+
+        mark_source(*while_stmt.get_cond());
+        dest += "j .L";
+        dest += std::to_string(if_label);
+        dest += '\n';
+
+        dest += ".L";
+        dest += std::to_string(fi_label);
+        dest += ":\n";
+    }
+
+    emit_promoted_stores(outer_size);
+    this->active_promotions.resize(outer_size);
+    this->current_local_pos = outer_local_pos;
+}
+
+void ASTCodegenVisitor::emit_cold_blocks()
+{
+    // Cold blocks may have cold blocks of their own.
+    for(size_t i = 0; i < cold_blocks.size(); ++i)
+    {
+        auto block = cold_blocks[i];
+        this->active_promotions = std::move(block.active_promotions);
+        this->current_local_pos = block.local_pos;
+
+        dest += ".L";
+        dest += std::to_string(block.label);
+        dest += ":\n";
+
+        if(auto expr = block.stmt->as_expr_stmt())
+            mark_source(*expr);
+        visit_stmt(*block.stmt);
+
+        dest += "j .L";
+        dest += std::to_string(block.join_label);
+        dest += '\n';
+    }
+
+    this->cold_blocks.clear();
+    this->active_promotions.clear();
+    this->current_local_pos = 0;
 }
 
 void ASTCodegenVisitor::visit_return_stmt(ASTReturnStmt& retn_stmt)
 {
     if(retn_stmt.get_expr())
+    {
+        mark_source(*retn_stmt.get_expr());
         visit_expr(*retn_stmt.get_expr());
+    }
+
+    emit_promoted_stores(0);
 
     // Function epilogue
     dest += "j .L";
@@ -338,6 +608,31 @@ void ASTCodegenVisitor::visit_return_stmt(ASTReturnStmt& retn_stmt)
 
 void ASTCodegenVisitor::visit_binary_expr(ASTBinaryExpr& expr)
 {
+    if(auto value = get_constant(expr))
+    {
+        emit_load_constant(*value);
+        return;
+    }
+
+    if(expr.get_operation() == ASTBinaryExpr::Operation::Assign)
+    {
+        const auto reg = get_promoted_reg(*expr.get_left()->as_var_expr()->get_decl());
+        if(reg != -1)
+        {
+            visit_expr(*expr.get_right());
+            emit_move(reg, REG_V0);
+            return;
+        }
+    }
+
+    const auto access = get_element_access(expr);
+    if(access.kind == ElementAccess::Defer)
+    {
+        visit_expr(*expr.get_right());
+        emit_move(access.reg, REG_V0);
+        return;
+    }
+
     const auto temp_bytes = 4;
     const auto temp_pos = temp_alloc(temp_bytes);
 
@@ -353,8 +648,17 @@ void ASTCodegenVisitor::visit_binary_expr(ASTBinaryExpr& expr)
     emit_frame_sw(REG_V0, temp_pos);
     visit_expr(*expr.get_right());
     emit_frame_lw(REG_T0, temp_pos);
+    emit_binary_operation(expr.get_operation());
+
+    if(access.kind == ElementAccess::Keep)
+        emit_move(access.reg, REG_V0);
+
+    temp_free(temp_pos, temp_bytes);
+}
 
-    switch(expr.get_operation())
+void ASTCodegenVisitor::emit_binary_operation(ASTBinaryExpr::Operation op)
+{
+    switch(op)
     {
         case ASTBinaryExpr::Operation::Plus:
             dest += "addu $v0, $t0, $v0\n";
@@ -396,47 +700,203 @@ void ASTCodegenVisitor::visit_binary_expr(ASTBinaryExpr& expr)
             dest += "sw $v0, 0($t0)\n";
             break;
     }
+}
+
+void ASTCodegenVisitor::visit_compound_assign_expr(ASTCompoundAssignExpr& expr)
+{
+    using Operation = ASTCompoundAssignExpr::Operation;
+
+    auto& var = *expr.get_var();
+    const auto step = get_constant_step(expr);
+
+    const auto emit_addiu = [&](int dest_reg, int source_reg) {
+        dest += "addiu $";
+        dest += regname(dest_reg);
+        dest += ", $";
+        dest += regname(source_reg);
+        dest += ", ";
+        dest += std::to_string(*step);
+        dest += '\n';
+    };
+
+    const auto emit_operation = [&](const char* dest_reg, const char* lhs_reg) {
+        switch(expr.get_operation())
+        {
+            case Operation::Plus:
+            case Operation::Minus:
+                dest += expr.get_operation() == Operation::Plus ? "addu $" : "subu $";
+                dest += dest_reg;
+                dest += ", $";
+                dest += lhs_reg;
+                dest += ", $v0\n";
+                break;
+            case Operation::Multiply:
+            case Operation::Divide:
+                dest += expr.get_operation() == Operation::Multiply ? "mult $" : "div $";
+                dest += lhs_reg;
+                dest += ", $v0\n";
+                dest += "mflo $";
+                dest += dest_reg;
+                dest += '\n';
+                break;
+            default:
+                cminus_unreachable();
+        }
+    };
+
+    const auto reg = get_promoted_reg(*var.get_decl());
+    if(reg != -1)
+    {
+        if(step)
+        {
+            if(expr.yields_old_value())
+                emit_move(REG_V0, reg);
+            emit_addiu(reg, reg);
+            if(!expr.yields_old_value())
+                emit_move(REG_V0, reg);
+            return;
+        }
+
+        assert(!expr.yields_old_value());
+        visit_expr(*expr.get_right());
+        emit_operation(regname(reg), regname(reg));
+        emit_move(REG_V0, reg);
+        return;
+    }
+
+    // The address is computed once, for both the load and the store.
+    if(step)
+    {
+        load_address_of(var);
+        emit_move(REG_V1, REG_V0);
+        dest += "lw $v0, 0($v1)\n";
+        if(expr.yields_old_value())
+        {
+            emit_addiu(REG_T0, REG_V0);
+            dest += "sw $t0, 0($v1)\n";
+        }
+        else
+        {
+            emit_addiu(REG_V0, REG_V0);
+            dest += "sw $v0, 0($v1)\n";
+        }
+        return;
+    }
+
+    assert(!expr.yields_old_value());
+
+    const auto temp_bytes = 4;
+    const auto temp_pos = temp_alloc(temp_bytes);
+
+    load_address_of(var);
+    emit_frame_sw(REG_V0, temp_pos);
+    visit_expr(*expr.get_right());
+    emit_frame_lw(REG_T0, temp_pos);
+    dest += "lw $v1, 0($t0)\n";
+    emit_operation("v0", "v1");
+    dest += "sw $v0, 0($t0)\n";
 
     temp_free(temp_pos, temp_bytes);
 }
 
 void ASTCodegenVisitor::visit_number_expr(ASTNumber& num)
 {
-    dest += "li $v0, ";
-    dest += std::to_string(num.get_value());
-    dest += '\n';
+    emit_load_constant(num.get_value());
 }
 
 void ASTCodegenVisitor::visit_var_expr(ASTVarRef& var)
 {
+    if(auto value = get_constant(var))
+    {
+        emit_load_constant(*value);
+        return;
+    }
+
+    const auto reg = get_promoted_reg(*var.get_decl());
+    if(reg != -1)
+    {
+        emit_move(REG_V0, reg);
+        return;
+    }
+
+    const auto access = get_element_access(var);
+    if(access.kind == ElementAccess::Reuse)
+    {
+        emit_move(REG_V0, access.reg);
+        return;
+    }
+
     load_address_of(var);
     if(var.type() != ExprType::Array)
         dest += "lw $v0, 0($v0)\n";
+
+    if(access.kind == ElementAccess::Keep)
+        emit_move(access.reg, REG_V0);
 }
 
 void ASTCodegenVisitor::visit_call_expr(ASTFunCall& fun_call)
 {
     auto fun_decl = fun_call.get_decl();
 
+    const auto num_params = static_cast<int32_t>(fun_decl->get_num_params());
+    if(num_params > 4)
+        this->current_frame.output_size = std::max(current_frame.output_size, 4 * (num_params - 4));
+
+    // An argument making a call clobbers the arguments evaluated before it,
+    // e.g. `f(alloc(n), alloc(n))`, so those are kept in temporaries until
+    // the last such argument is evaluated.
+    size_t num_spilled = 0;
     size_t argcount = 0;
-    for(auto it = fun_call.arg_begin();
-        it != fun_call.arg_end();
-        ++it, ++argcount)
+    for(auto it = fun_call.arg_begin(); it != fun_call.arg_end(); ++it, ++argcount)
     {
-        visit_expr(**it);
+        if(argcount != 0 && makes_call(**it))
+            num_spilled = argcount;
+    }
 
+    const auto temp_bytes = static_cast<int32_t>(4 * num_spilled);
+    const auto temp_pos = temp_alloc(temp_bytes);
+
+    const auto emit_arg = [&](size_t argcount, int reg) {
         if(argcount < 4)
         {
             dest += "add $";
             dest += regname(REG_A0 + argcount);
-            dest += ", $v0, $0\n";
+            dest += ", $";
+            dest += regname(reg);
+            dest += ", $0\n";
+        }
+        else
+        {
+            const auto offset = static_cast<int32_t>(4 * (argcount - 4));
+            emit_frame_sw(reg, FrameSlot{FrameSlot::Output, offset});
+        }
+    };
+
+    argcount = 0;
+    for(auto it = fun_call.arg_begin(); it != fun_call.arg_end(); ++it, ++argcount)
+    {
+        visit_expr(**it);
+
+        if(argcount < num_spilled)
+        {
+            const auto offset = static_cast<int32_t>(4 * argcount);
+            emit_frame_sw(REG_V0, FrameSlot{FrameSlot::Temp, temp_pos.offset + offset});
         }
         else
         {
-            emit_frame_sw(REG_V0, current_frame.output_offset(4 * (argcount - 4)));
+            emit_arg(argcount, REG_V0);
         }
     }
 
+    for(argcount = 0; argcount < num_spilled; ++argcount)
+    {
+        const auto offset = static_cast<int32_t>(4 * argcount);
+        emit_frame_lw(REG_T0, FrameSlot{FrameSlot::Temp, temp_pos.offset + offset});
+        emit_arg(argcount, REG_T0);
+    }
+
+    temp_free(temp_pos, temp_bytes);
+
     dest += "jal ";
     dest += fun_decl->get_name();
     dest += '\n';
@@ -452,50 +912,355 @@ void ASTCodegenVisitor::visit_name(SourceRange name)
     // No code needs to be generated for this.
 }
 
+void ASTCodegenVisitor::mark_source(SourceLocation loc)
+{
+    if(line_map == nullptr)
+        return;
+
+    this->line_map_line += std::count(dest.begin() + line_map_offset, dest.end(), '\n');
+    this->line_map_offset = dest.size();
+
+    // A previous mark on the same line covers no code, so forget about it.
+    if(!line_map->empty() && line_map->back().asm_line == line_map_line)
+        line_map->pop_back();
+
+    if(!line_map->empty() && line_map->back().loc == loc
+       && line_map->back().fun == current_fun)
+        return;
+
+    line_map->push_back(LineMapEntry{line_map_line, loc, current_fun});
+}
+
+void ASTCodegenVisitor::mark_source(const ASTExpr& expr)
+{
+    if(line_map != nullptr)
+        mark_source(source_table->location(expr));
+}
+
+auto ASTCodegenVisitor::get_constant(const ASTExpr& expr) const
+        -> std::optional<int32_t>
+{
+    if(!constants)
+        return std::nullopt;
+    return constants->get_constant(expr);
+}
+
+bool ASTCodegenVisitor::is_unreachable(const ASTStmt& stmt) const
+{
+    return constants && constants->is_unreachable(stmt);
+}
+
+auto ASTCodegenVisitor::get_element_access(const ASTExpr& expr) const
+        -> ElementAccess
+{
+    if(!elements)
+        return ElementAccess{};
+    return elements->get_access(expr);
+}
+
+int ASTCodegenVisitor::get_promoted_reg(const ASTVarDecl& var) const
+{
+    for(const auto& global : active_promotions)
+    {
+        if(global.var == &var)
+            return global.reg;
+    }
+    return -1;
+}
+
+void ASTCodegenVisitor::emit_promoted_stores(size_t outer_size)
+{
+    for(size_t i = outer_size; i < active_promotions.size(); ++i)
+    {
+        const auto& global = active_promotions[i];
+        if(global.is_modified)
+        {
+            dest += "sw $";
+            dest += regname(global.reg);
+            dest += ", ";
+            dest += global.var->get_name();
+            dest += '\n';
+        }
+    }
+}
+
+void ASTCodegenVisitor::emit_move(int dest_reg, int source_reg)
+{
+    dest += "move $";
+    dest += regname(dest_reg);
+    dest += ", $";
+    dest += regname(source_reg);
+    dest += '\n';
+}
+
+void ASTCodegenVisitor::emit_load_constant(int32_t value)
+{
+    dest += "li $v0, ";
+    dest += std::to_string(value);
+    dest += '\n';
+}
+
+size_t ASTCodegenVisitor::count_frameless_guards(ASTFunDecl& decl)
+{
+    // The profiler must see every call from the prologue.
+    if(!options.optimize || options.profile)
+        return 0;
+
+    auto body = decl.get_body();
+    size_t count = 0;
+    for(auto it = body->stmt_begin(); it != body->stmt_end(); ++it, ++count)
+    {
+        auto if_stmt = (*it)->as_selection_stmt();
+        if(!if_stmt || if_stmt->get_else() || !is_frameless(*if_stmt->get_cond())
+           || get_constant(*if_stmt->get_cond()))
+            break;
+
+        auto retn_stmt = if_stmt->get_then()->as_return_stmt();
+        if(auto comp_stmt = if_stmt->get_then()->as_compound_stmt())
+        {
+            if(comp_stmt->decl_begin() == comp_stmt->decl_end()
+               && std::distance(comp_stmt->stmt_begin(), comp_stmt->stmt_end()) == 1)
+                retn_stmt = (*comp_stmt->stmt_begin())->as_return_stmt();
+        }
+
+        if(!retn_stmt || (retn_stmt->get_expr() && !is_frameless(*retn_stmt->get_expr())))
+            break;
+    }
+    return count;
+}
+
+bool ASTCodegenVisitor::is_frameless(ASTExpr& expr)
+{
+    if(get_constant(expr) || expr.as_number_expr())
+        return true;
+
+    if(auto var_ref = expr.as_var_expr())
+    {
+        const auto& var = *var_ref->get_decl();
+        return var_ref->type() == ExprType::Int && !var_ref->get_index()
+               && (get_param_reg(var) != -1 || aliases->is_global(var));
+    }
+
+    // The right hand side must be computable without touching $t0.
+    auto binary = expr.as_binary_expr();
+    return binary && binary->get_operation() != ASTBinaryExpr::Operation::Assign
+           && is_frameless(*binary->get_left())
+           && !binary->get_right()->as_binary_expr() && is_frameless(*binary->get_right());
+}
+
+void ASTCodegenVisitor::emit_frameless_expr(ASTExpr& expr)
+{
+    assert(is_frameless(expr));
+
+    if(auto value = get_constant(expr))
+    {
+        emit_load_constant(*value);
+    }
+    else if(auto number = expr.as_number_expr())
+    {
+        emit_load_constant(number->get_value());
+    }
+    else if(auto var_ref = expr.as_var_expr())
+    {
+        const auto reg = get_param_reg(*var_ref->get_decl());
+        if(reg != -1)
+        {
+            emit_move(REG_V0, reg);
+        }
+        else
+        {
+            load_base_address(*var_ref->get_decl());
+            dest += "lw $v0, 0($v0)\n";
+        }
+    }
+    else
+    {
+        auto binary = expr.as_binary_expr();
+        emit_frameless_expr(*binary->get_left());
+        emit_move(REG_T0, REG_V0);
+        emit_frameless_expr(*binary->get_right());
+        emit_binary_operation(binary->get_operation());
+    }
+}
+
+void ASTCodegenVisitor::emit_frameless_guard(ASTSelectionStmt& if_stmt)
+{
+    const auto false_label = next_label_id();
+
+    mark_source(*if_stmt.get_cond());
+    emit_frameless_expr(*if_stmt.get_cond());
+
+    dest += "beq $v0, $0, .L";
+    dest += std::to_string(false_label);
+    dest += '\n';
+
+    auto retn_stmt = if_stmt.get_then()->as_return_stmt();
+    if(!retn_stmt)
+        retn_stmt = (*if_stmt.get_then()->as_compound_stmt()->stmt_begin())->as_return_stmt();
+    if(auto expr = retn_stmt->get_expr())
+    {
+        mark_source(*expr);
+        emit_frameless_expr(*expr);
+    }
+    dest += "jr $ra\n";
+
+    dest += ".L";
+    dest += std::to_string(false_label);
+    dest += ":\n";
+}
+
+int ASTCodegenVisitor::get_param_reg(const ASTVarDecl& var) const
+{
+    auto it = local_pos.find(const_cast<ASTVarDecl*>(&var));
+    if(it == local_pos.end() || it->second.block != FrameSlot::Input || it->second.offset >= 16)
+        return -1;
+    return REG_A0 + it->second.offset / 4;
+}
+
+auto ASTCodegenVisitor::get_constant_step(ASTCompoundAssignExpr& expr) const
+        -> std::optional<int32_t>
+{
+    using Operation = ASTCompoundAssignExpr::Operation;
+    if(expr.get_operation() != Operation::Plus && expr.get_operation() != Operation::Minus)
+        return std::nullopt;
+
+    // Only expressions without side effects may be left unevaluated.
+    std::optional<int32_t> value;
+    if(auto number = expr.get_right()->as_number_expr())
+        value = number->get_value();
+    else if(auto var_ref = expr.get_right()->as_var_expr(); var_ref && !var_ref->get_index())
+        value = get_constant(*var_ref);
+    if(!value)
+        return std::nullopt;
+
+    const auto step = (expr.get_operation() == Operation::Minus ? -int64_t(*value) : *value);
+    if(step < INT16_MIN || step > INT16_MAX)
+        return std::nullopt;
+    return static_cast<int32_t>(step);
+}
+
 void ASTCodegenVisitor::load_address_of(ASTVarRef& var_ref)
 {
     auto var_decl = var_ref.get_decl();
 
-    auto it = local_pos.find(var_decl.get());
+    const auto row_id = rows ? rows->get_row_id(var_ref) : -1;
+    if(row_id != -1)
+    {
+        if(this->function_label_goto_ob == -1)
+            this->function_label_goto_ob = next_label_id();
+
+        emit_frame_lw(REG_V0, row_slots.at(row_id));
+
+        // Check negative row, which was kept as is.
+        dest += "bltzal $v0, .L";
+        dest += std::to_string(function_label_goto_ob);
+        dest += '\n';
+
+        emit_add_index(*var_ref.get_col_index(), 4);
+        return;
+    }
+
+    load_base_address(*var_decl);
+
+    if(auto index_expr = var_ref.get_index())
+    {
+        emit_add_index(*index_expr, static_cast<int32_t>(var_decl->get_row_bytes()));
+    }
+
+    if(auto col_index_expr = var_ref.get_col_index())
+        emit_add_index(*col_index_expr, 4);
+}
+
+void ASTCodegenVisitor::load_base_address(ASTVarDecl& var_decl)
+{
+    auto it = local_pos.find(&var_decl);
     if(it != local_pos.end())
     {
-        auto frame_offset = current_frame.local_offset(it->second);
         dest += "addiu $v0, $sp, ";
-        dest += std::to_string(frame_offset);
+        emit_frame_offset(it->second);
         dest += '\n';
-        ;
 
-        if(var_decl->is_pointer())
+        if(var_decl.is_pointer())
             dest += "lw $v0, 0($v0)\n";
     }
     else
     {
         dest += "la $v0, ";
-        dest += var_decl->get_name();
+        dest += var_decl.get_name();
         dest += '\n';
     }
+}
 
-    if(auto index_expr = var_ref.get_index())
-    {
-        const auto temp_bytes = 4;
-        const auto temp_pos = temp_alloc(temp_bytes);
+void ASTCodegenVisitor::emit_add_index(ASTExpr& index, int32_t stride)
+{
+    const auto temp_bytes = 4;
+    const auto temp_pos = temp_alloc(temp_bytes);
 
-        if(this->function_label_goto_ob == -1)
-            this->function_label_goto_ob = next_label_id();
+    if(this->function_label_goto_ob == -1)
+        this->function_label_goto_ob = next_label_id();
 
-        emit_frame_sw(REG_V0, temp_pos);
-        visit_expr(*index_expr);
+    emit_frame_sw(REG_V0, temp_pos);
+    visit_expr(index);
 
-        // Check negative index.
-        dest += "bltzal $v0, .L";
-        dest += std::to_string(function_label_goto_ob);
-        dest += '\n';
+    // Check negative index.
+    dest += "bltzal $v0, .L";
+    dest += std::to_string(function_label_goto_ob);
+    dest += '\n';
 
-        dest += "sll $v0, $v0, 2\n";
-        emit_frame_lw(REG_T0, temp_pos);
-        dest += "addu $v0, $t0, $v0\n";
+    emit_scale(stride);
+    emit_frame_lw(REG_T0, temp_pos);
+    dest += "addu $v0, $t0, $v0\n";
 
-        temp_free(temp_pos, temp_bytes);
+    temp_free(temp_pos, temp_bytes);
+}
+
+void ASTCodegenVisitor::emit_scale(int32_t factor)
+{
+    assert(factor >= 0);
+
+    // Beyond this many set bits, a multiplication is cheaper.
+    constexpr int max_adds = 3;
+
+    std::vector<int> bits;
+    for(int bit = 31; bit >= 0; --bit)
+    {
+        if(factor & (int32_t(1) << bit))
+            bits.push_back(bit);
+    }
+
+    if(bits.empty())
+    {
+        dest += "move $v0, $0\n";
+    }
+    else if(bits.size() == 1)
+    {
+        dest += "sll $v0, $v0, ";
+        dest += std::to_string(bits[0]);
+        dest += '\n';
+    }
+    else if(bits.size() <= max_adds + 1)
+    {
+        // Horner's rule over the set bits, from the highest down, e.g.
+        // 20 * x is ((x << 2) + x) << 2.
+        dest += "move $v1, $v0\n";
+        for(size_t i = 1; i < bits.size(); ++i)
+        {
+            dest += "sll $v1, $v1, ";
+            dest += std::to_string(bits[i - 1] - bits[i]);
+            dest += '\n';
+            dest += "addu $v1, $v1, $v0\n";
+        }
+        dest += "sll $v0, $v1, ";
+        dest += std::to_string(bits.back());
+        dest += '\n';
+    }
+    else
+    {
+        dest += "li $v1, ";
+        dest += std::to_string(factor);
+        dest += '\n';
+        dest += "mult $v0, $v1\n";
+        dest += "mflo $v0\n";
     }
 }
 
@@ -529,36 +1294,88 @@ int32_t ASTCodegenVisitor::FrameInfo::input_offset(int32_t offset) const
     return local_offset(local_size) + offset;
 }
 
-void ASTCodegenVisitor::emit_frame_sw(int reg, int32_t frame_offset)
+int32_t ASTCodegenVisitor::FrameInfo::offset_of(FrameSlot slot) const
+{
+    switch(slot.block)
+    {
+        case FrameSlot::Output:
+            return output_offset(slot.offset);
+        case FrameSlot::Temp:
+            return temp_offset(slot.offset);
+        case FrameSlot::Saved:
+            return saved_offset(slot.offset);
+        case FrameSlot::Local:
+            return local_offset(slot.offset);
+        case FrameSlot::Input:
+            return input_offset(slot.offset);
+        case FrameSlot::End:
+            return static_cast<int32_t>(total_size()) + slot.offset;
+        default:
+            cminus_unreachable();
+    }
+}
+
+void ASTCodegenVisitor::emit_frame_offset(FrameSlot slot)
+{
+    this->frame_fixups.push_back(FrameFixup{dest.size(), slot});
+}
+
+void ASTCodegenVisitor::patch_frame_offsets()
+{
+    // Offsets contain no newlines, so the line map may catch up beforehand.
+    if(line_map != nullptr)
+    {
+        this->line_map_line += std::count(dest.begin() + line_map_offset, dest.end(), '\n');
+        this->line_map_offset = dest.size();
+    }
+
+    std::string code;
+    code.reserve(dest.size() - function_begin + 4 * frame_fixups.size());
+
+    auto pos = function_begin;
+    for(const auto& fixup : frame_fixups)
+    {
+        code.append(dest, pos, fixup.pos - pos);
+        code += std::to_string(current_frame.offset_of(fixup.slot));
+        pos = fixup.pos;
+    }
+    code.append(dest, pos, std::string::npos);
+
+    this->dest.resize(function_begin);
+    this->dest += code;
+    this->line_map_offset = dest.size();
+}
+
+void ASTCodegenVisitor::emit_frame_sw(int reg, FrameSlot slot)
 {
     dest += "sw $";
     dest += regname(reg);
     dest += ", ";
-    dest += std::to_string(frame_offset);
+    emit_frame_offset(slot);
     dest += "($sp)\n";
 }
 
-void ASTCodegenVisitor::emit_frame_lw(int reg, int32_t frame_offset)
+void ASTCodegenVisitor::emit_frame_lw(int reg, FrameSlot slot)
 {
     dest += "lw $";
     dest += regname(reg);
     dest += ", ";
-    dest += std::to_string(frame_offset);
+    emit_frame_offset(slot);
     dest += "($sp)\n";
 }
 
-int32_t ASTCodegenVisitor::temp_alloc(int32_t size)
+auto ASTCodegenVisitor::temp_alloc(int32_t size) -> FrameSlot
 {
-    auto result = current_temp_pos;
+    auto result = FrameSlot{FrameSlot::Temp, current_temp_pos};
     this->current_temp_pos += size;
-    assert(current_temp_pos <= current_frame.temp_size);
-    return current_frame.temp_offset(result);
+    this->current_frame.temp_size = std::max(current_frame.temp_size, current_temp_pos);
+    return result;
 }
 
-void ASTCodegenVisitor::temp_free(int32_t offset, int32_t size)
+void ASTCodegenVisitor::temp_free(FrameSlot slot, int32_t size)
 {
     this->current_temp_pos -= size;
-    assert(current_frame.temp_offset(current_temp_pos) == offset);
+    assert(slot.block == FrameSlot::Temp && slot.offset == current_temp_pos);
 }
 
 int32_t ASTCodegenVisitor::next_label_id()
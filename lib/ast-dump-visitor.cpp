@@ -109,6 +109,24 @@ void ASTDumpVisitor::visit_fun_decl(ASTFunDecl& decl)
     }
     dest += ']';
 
+    // Functions without attributes are dumped as the C- specification says.
+    if(!!decl.get_attributes())
+    {
+        newline(depth + 1);
+        dest += '[';
+        dest += "attributes";
+        for(const auto& [name, attr] : fun_attribute_names)
+        {
+            if(decl.has_attribute(attr))
+            {
+                dest += " [";
+                dest += name;
+                dest += ']';
+            }
+        }
+        dest += ']';
+    }
+
     ++depth;
     visit_compound_stmt(*decl.get_body());
     --depth;
@@ -197,6 +215,31 @@ void ASTDumpVisitor::visit_binary_expr(ASTBinaryExpr& expr)
     dest += ']';
 }
 
+void ASTDumpVisitor::visit_compound_assign_expr(ASTCompoundAssignExpr& expr)
+{
+    using Form = ASTCompoundAssignExpr::Form;
+
+    newline(depth);
+    dest += '[';
+    if(expr.get_form() == Form::Postfix)
+        dest += "post";
+    dest += operation(expr.get_operation());
+    if(expr.get_form() == Form::Compound)
+        dest += '=';
+    else
+        dest += operation(expr.get_operation());
+    dest += ' ';
+
+    ++depth;
+    if(expr.get_form() == Form::Compound)
+        walk_compound_assign_expr(expr);
+    else
+        visit_var_expr(*expr.get_var());
+    --depth;
+
+    dest += ']';
+}
+
 void ASTDumpVisitor::visit_number_expr(ASTNumber& num)
 {
     dest += " [";
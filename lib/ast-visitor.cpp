@@ -30,6 +30,8 @@ void ASTVisitor::walk_var_decl(ASTVarDecl& var_decl)
     visit_name(var_decl.get_name());
     if(auto size = var_decl.get_array_size())
         visit_number_expr(*size);
+    if(auto cols = var_decl.get_array_cols())
+        visit_number_expr(*cols);
 }
 
 void ASTVisitor::walk_parm_decl(ASTParmVarDecl& parm_decl)
@@ -121,6 +123,9 @@ void ASTVisitor::walk_expr(ASTExpr& expr)
         case ExprKind::AssignExpr:
             visit_binary_expr(*expr.as_binary_expr());
             break;
+        case ExprKind::CompoundAssignExpr:
+            visit_compound_assign_expr(*expr.as_compound_assign_expr());
+            break;
     }
 }
 
@@ -134,6 +139,8 @@ void ASTVisitor::walk_var_expr(ASTVarRef& var_ref)
     visit_name(var_ref.get_decl()->get_name());
     if(auto expr = var_ref.get_index())
         visit_expr(*expr);
+    if(auto expr = var_ref.get_col_index())
+        visit_expr(*expr);
 }
 
 void ASTVisitor::walk_call_expr(ASTFunCall& fun_call)
@@ -149,6 +156,12 @@ void ASTVisitor::walk_binary_expr(ASTBinaryExpr& expr)
     visit_expr(*expr.get_right());
 }
 
+void ASTVisitor::walk_compound_assign_expr(ASTCompoundAssignExpr& expr)
+{
+    visit_var_expr(*expr.get_var());
+    visit_expr(*expr.get_right());
+}
+
 void ASTVisitor::walk_type(ExprType)
 {
     // nothing to visit
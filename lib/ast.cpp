@@ -3,6 +3,34 @@
 
 namespace cminus
 {
+auto ASTSourceTable::add(SourceRange range) -> ASTNodeId
+{
+    this->ranges.push_back(range);
+    return static_cast<ASTNodeId>(ranges.size() - 1);
+}
+
+auto ASTSourceTable::source_range(const ASTExpr& expr) const -> SourceRange
+{
+    assert(expr.node_id() < ranges.size());
+    return ranges[expr.node_id()];
+}
+
+auto ASTVarDecl::get_num_elements() const -> int64_t
+{
+    if(!array_size)
+        return 1;
+    if(!array_cols)
+        return array_size->get_value();
+    return int64_t(array_size->get_value()) * array_cols->get_value();
+}
+
+auto ASTVarDecl::get_row_bytes() const -> int64_t
+{
+    if(!array_cols)
+        return 4;
+    return 4 * int64_t(array_cols->get_value());
+}
+
 auto ASTBinaryExpr::type_from_category(Category category) -> Operation
 {
     switch(category)
@@ -33,4 +61,23 @@ auto ASTBinaryExpr::type_from_category(Category category) -> Operation
             cminus_unreachable();
     }
 }
+
+auto ASTCompoundAssignExpr::type_from_category(Category category) -> Operation
+{
+    switch(category)
+    {
+        case Category::PlusAssign:
+        case Category::Increment:
+            return Operation::Plus;
+        case Category::MinusAssign:
+        case Category::Decrement:
+            return Operation::Minus;
+        case Category::MultiplyAssign:
+            return Operation::Multiply;
+        case Category::DivideAssign:
+            return Operation::Divide;
+        default:
+            cminus_unreachable();
+    }
+}
 }
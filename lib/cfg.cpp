@@ -0,0 +1,158 @@
+#include <cminus/cfg.hpp>
+#include <cminus/utility/contracts.hpp>
+
+namespace
+{
+using namespace cminus;
+
+/// Builds a control flow graph by walking the statements of a function.
+class CFGBuilder
+{
+public:
+    explicit CFGBuilder(CFG& cfg) :
+        cfg(cfg)
+    {
+    }
+
+    /// Appends the flow of a statement to the current block.
+    void build_stmt(ASTStmt& stmt)
+    {
+        switch(stmt.stmt_kind())
+        {
+            case StmtKind::NullStmt:
+                break;
+            case StmtKind::ExprStmt:
+                cfg.block(current).exprs.push_back(static_cast<ASTExpr*>(&stmt));
+                break;
+            case StmtKind::CompoundStmt:
+                build_compound_stmt(static_cast<ASTCompoundStmt&>(stmt));
+                break;
+            case StmtKind::SelectionStmt:
+                build_selection_stmt(static_cast<ASTSelectionStmt&>(stmt));
+                break;
+            case StmtKind::IterationStmt:
+                build_iteration_stmt(static_cast<ASTIterationStmt&>(stmt));
+                break;
+            case StmtKind::ReturnStmt:
+                build_return_stmt(static_cast<ASTReturnStmt&>(stmt));
+                break;
+            default:
+                cminus_unreachable();
+        }
+    }
+
+    void build_compound_stmt(ASTCompoundStmt& comp_stmt)
+    {
+        for(auto it = comp_stmt.stmt_begin(); it != comp_stmt.stmt_end(); ++it)
+            build_stmt(**it);
+    }
+
+    void build_selection_stmt(ASTSelectionStmt& if_stmt)
+    {
+        const auto cond_block = current;
+        const auto then_block = cfg.add_block();
+        const auto fi_block = cfg.add_block();
+        const auto else_block = if_stmt.get_else() ? cfg.add_block() : fi_block;
+
+        end_block(cond_block, CFGBlock::Branch, if_stmt.get_cond().get(), &if_stmt);
+        cfg.add_edge(cond_block, then_block);
+        cfg.add_edge(cond_block, else_block);
+
+        this->current = then_block;
+        build_stmt(*if_stmt.get_then());
+        cfg.add_edge(current, fi_block);
+
+        if(auto else_stmt = if_stmt.get_else())
+        {
+            this->current = else_block;
+            build_stmt(*else_stmt);
+            cfg.add_edge(current, fi_block);
+        }
+
+        this->current = fi_block;
+    }
+
+    void build_iteration_stmt(ASTIterationStmt& while_stmt)
+    {
+        const auto cond_block = cfg.add_block();
+        const auto body_block = cfg.add_block();
+        const auto exit_block = cfg.add_block();
+
+        cfg.add_edge(current, cond_block);
+
+        end_block(cond_block, CFGBlock::Branch, while_stmt.get_cond().get(), &while_stmt);
+        cfg.add_edge(cond_block, body_block);
+        cfg.add_edge(cond_block, exit_block);
+
+        this->current = body_block;
+        build_stmt(*while_stmt.get_body());
+        cfg.add_edge(current, cond_block);
+
+        this->current = exit_block;
+    }
+
+    void build_return_stmt(ASTReturnStmt& retn_stmt)
+    {
+        if(auto expr = retn_stmt.get_expr())
+            cfg.block(current).exprs.push_back(expr.get());
+
+        end_block(current, CFGBlock::Goto, nullptr, &retn_stmt);
+        cfg.add_edge(current, cfg.exit());
+
+        // Anything after the return statement is unreachable.
+        this->current = cfg.add_block();
+    }
+
+    /// Finishes the current block with a terminator.
+    void end_block(CFGBlockId id, CFGBlock::Terminator terminator,
+                   ASTExpr* cond, ASTStmt* stmt)
+    {
+        auto& block = cfg.block(id);
+        block.terminator = terminator;
+        block.cond = cond;
+        block.stmt = stmt;
+    }
+
+    /// The block where the flow of the next statement is appended to.
+    CFGBlockId current = 0;
+
+private:
+    CFG& cfg;
+};
+}
+
+namespace cminus
+{
+auto CFG::build(ASTFunDecl& decl) -> CFG
+{
+    assert(decl.get_body() != nullptr);
+
+    CFG cfg;
+    const auto entry = cfg.add_block();
+    const auto exit = cfg.add_block();
+    assert(entry == cfg.entry() && exit == cfg.exit());
+
+    cfg.block(exit).terminator = CFGBlock::Exit;
+
+    CFGBuilder builder(cfg);
+    builder.current = entry;
+    builder.build_compound_stmt(*decl.get_body());
+
+    // Falling off the end of the function is an implicit return.
+    cfg.add_edge(builder.current, exit);
+
+    return cfg;
+}
+
+auto CFG::add_block() -> CFGBlockId
+{
+    this->blocks.emplace_back();
+    return static_cast<CFGBlockId>(blocks.size() - 1);
+}
+
+void CFG::add_edge(CFGBlockId from, CFGBlockId to)
+{
+    this->blocks[from].succs.push_back(to);
+    this->blocks[to].preds.push_back(from);
+}
+}
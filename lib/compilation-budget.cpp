@@ -0,0 +1,65 @@
+#include <cminus/compilation-budget.hpp>
+#include <cminus/utility/contracts.hpp>
+
+namespace cminus
+{
+void CompilationBudget::charge_memory(size_t bytes)
+{
+    this->memory += bytes;
+    if(limits.max_memory && memory > limits.max_memory)
+        exhaust(BudgetReason::Memory);
+}
+
+void CompilationBudget::charge_ast_node(size_t bytes)
+{
+    ++this->ast_nodes;
+    if(limits.max_ast_nodes && ast_nodes > limits.max_ast_nodes)
+        exhaust(BudgetReason::AstNodes);
+    charge_memory(bytes);
+}
+
+bool CompilationBudget::check_output(size_t bytes)
+{
+    if(limits.max_output && bytes > limits.max_output)
+        exhaust(BudgetReason::Output);
+    return poll();
+}
+
+void CompilationBudget::check_time()
+{
+    if(!limits.max_time_ms)
+        return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if(elapsed > std::chrono::milliseconds(limits.max_time_ms))
+        exhaust(BudgetReason::Time);
+}
+
+void CompilationBudget::exhaust(BudgetReason why)
+{
+    // The first reason sticks.
+    auto expected = BudgetReason::None;
+    this->reason.compare_exchange_strong(expected, why, std::memory_order_relaxed);
+}
+
+auto CompilationBudget::reason_name(BudgetReason reason) -> std::string_view
+{
+    switch(reason)
+    {
+        case BudgetReason::None:
+            return "none";
+        case BudgetReason::Time:
+            return "time";
+        case BudgetReason::Memory:
+            return "memory";
+        case BudgetReason::AstNodes:
+            return "ast-nodes";
+        case BudgetReason::Output:
+            return "output";
+        case BudgetReason::Cancelled:
+            return "cancelled";
+        default:
+            cminus_unreachable();
+    }
+}
+}
@@ -0,0 +1,154 @@
+#include <cminus/ast-visitor.hpp>
+#include <cminus/compilation-stats.hpp>
+
+namespace
+{
+using namespace cminus;
+
+/// Counts the AST nodes of each kind.
+class NodeCounter : public ASTVisitor
+{
+public:
+    explicit NodeCounter(CompilationStats& stats) :
+        stats(stats)
+    {
+    }
+
+    void visit_var_decl(ASTVarDecl& decl) override
+    {
+        count(DeclKind::VarDecl);
+        walk_var_decl(decl);
+    }
+
+    void visit_parm_decl(ASTParmVarDecl& decl) override
+    {
+        count(DeclKind::ParmVarDecl);
+        walk_parm_decl(decl);
+    }
+
+    void visit_fun_decl(ASTFunDecl& decl) override
+    {
+        count(DeclKind::FunDecl);
+        count(*decl.get_body());
+        walk_fun_decl(decl);
+    }
+
+    // Expression statements are not visited on their own, thus statements
+    // are counted by their parent.
+
+    void visit_compound_stmt(ASTCompoundStmt& stmt) override
+    {
+        for(auto it = stmt.stmt_begin(); it != stmt.stmt_end(); ++it)
+            count(**it);
+        walk_compound_stmt(stmt);
+    }
+
+    void visit_selection_stmt(ASTSelectionStmt& stmt) override
+    {
+        count(*stmt.get_then());
+        if(stmt.get_else())
+            count(*stmt.get_else());
+        walk_selection_stmt(stmt);
+    }
+
+    void visit_iteration_stmt(ASTIterationStmt& stmt) override
+    {
+        count(*stmt.get_body());
+        walk_iteration_stmt(stmt);
+    }
+
+    void visit_number_expr(ASTNumber& expr) override
+    {
+        count(expr);
+        walk_number_expr(expr);
+    }
+
+    void visit_var_expr(ASTVarRef& expr) override
+    {
+        count(expr);
+        walk_var_expr(expr);
+    }
+
+    void visit_call_expr(ASTFunCall& expr) override
+    {
+        count(expr);
+        walk_call_expr(expr);
+    }
+
+    void visit_binary_expr(ASTBinaryExpr& expr) override
+    {
+        count(expr);
+        walk_binary_expr(expr);
+    }
+
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override
+    {
+        count(expr);
+        walk_compound_assign_expr(expr);
+    }
+
+private:
+    void count(DeclKind kind)
+    {
+        ++this->stats.decls[static_cast<size_t>(kind)];
+    }
+
+    void count(ASTStmt& stmt)
+    {
+        ++this->stats.stmts[static_cast<size_t>(stmt.stmt_kind())];
+    }
+
+    void count(ASTExpr& expr)
+    {
+        ++this->stats.exprs[static_cast<size_t>(expr.expr_kind())];
+    }
+
+private:
+    CompilationStats& stats;
+};
+}
+
+namespace cminus
+{
+void collect_ast_stats(ASTProgram& program, CompilationStats& stats)
+{
+    NodeCounter(stats).visit_program(program);
+}
+
+void collect_codegen_stats(
+        ASTProgram& program,
+        const std::unordered_map<ASTFunDecl*, ASTCodegenVisitor::FrameInfo>& frames,
+        std::string_view code,
+        CompilationStats& stats)
+{
+    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
+    {
+        if(auto fun_decl = (*it)->as_fun_decl())
+            stats.frames.emplace_back(fun_decl.get(), frames.at(fun_decl.get()));
+    }
+
+    // Each line holds either a label (possibly followed by a directive), a
+    // directive or an instruction.
+    while(!code.empty())
+    {
+        const auto newline = code.find('\n');
+        const auto line = code.substr(0, newline);
+        code.remove_prefix(newline == code.npos ? code.size() : newline + 1);
+
+        const auto opcode = line.substr(0, line.find(' '));
+        if(!opcode.empty() && opcode.back() == ':')
+        {
+            ++stats.labels;
+            continue;
+        }
+
+        if(opcode.empty() || opcode.front() == '.' || opcode.front() == '#')
+            continue;
+
+        auto it = stats.instructions.find(opcode);
+        if(it == stats.instructions.end())
+            it = stats.instructions.emplace(std::string(opcode), 0).first;
+        ++it->second;
+    }
+}
+}
@@ -0,0 +1,412 @@
+#include <cminus/constant-propagation.hpp>
+#include <cminus/utility/contracts.hpp>
+#include <limits>
+
+namespace
+{
+using namespace cminus;
+
+/// The value of a variable or expression in the constant lattice.
+///
+///     Top (not yet known) > Const (a single value) > Bottom (any value)
+///
+struct LatticeValue
+{
+    enum Kind : uint8_t
+    {
+        Top,
+        Const,
+        Bottom,
+    };
+
+    Kind kind = Top;
+    int32_t value = 0;
+
+    static auto constant(int32_t value) -> LatticeValue
+    {
+        return LatticeValue{Const, value};
+    }
+
+    static auto bottom() -> LatticeValue
+    {
+        return LatticeValue{Bottom, 0};
+    }
+
+    bool operator==(const LatticeValue& rhs) const
+    {
+        return kind == rhs.kind && (kind != Const || value == rhs.value);
+    }
+
+    bool operator!=(const LatticeValue& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+/// \returns the greatest lower bound of two values.
+auto meet(LatticeValue lhs, LatticeValue rhs) -> LatticeValue
+{
+    if(lhs.kind == LatticeValue::Top)
+        return rhs;
+    if(rhs.kind == LatticeValue::Top)
+        return lhs;
+    if(lhs == rhs)
+        return lhs;
+    return LatticeValue::bottom();
+}
+
+/// Evaluates a binary operation the same way the generated code would.
+auto fold(ASTBinaryExpr::Operation op, int32_t lhs, int32_t rhs) -> LatticeValue
+{
+    using Operation = ASTBinaryExpr::Operation;
+
+    // Arithmetic wraps around in the target.
+    const auto ulhs = static_cast<uint32_t>(lhs);
+    const auto urhs = static_cast<uint32_t>(rhs);
+
+    switch(op)
+    {
+        case Operation::Plus:
+            return LatticeValue::constant(static_cast<int32_t>(ulhs + urhs));
+        case Operation::Minus:
+            return LatticeValue::constant(static_cast<int32_t>(ulhs - urhs));
+        case Operation::Multiply:
+            return LatticeValue::constant(static_cast<int32_t>(ulhs * urhs));
+        case Operation::Divide:
+            // The result of these is unpredictable in the target.
+            if(rhs == 0 || (lhs == std::numeric_limits<int32_t>::min() && rhs == -1))
+                return LatticeValue::bottom();
+            return LatticeValue::constant(lhs / rhs);
+        case Operation::Less:
+            return LatticeValue::constant(lhs < rhs);
+        case Operation::LessEqual:
+            return LatticeValue::constant(lhs <= rhs);
+        case Operation::Greater:
+            return LatticeValue::constant(lhs > rhs);
+        case Operation::GreaterEqual:
+            return LatticeValue::constant(lhs >= rhs);
+        case Operation::Equal:
+            return LatticeValue::constant(lhs == rhs);
+        case Operation::NotEqual:
+            return LatticeValue::constant(lhs != rhs);
+        case Operation::Assign:
+        default:
+            cminus_unreachable();
+    }
+}
+
+/// Solves the dataflow problem of a function.
+class ConstantSolver
+{
+public:
+    /// The value of each tracked variable at some point in the function.
+    using Env = std::vector<LatticeValue>;
+
+    explicit ConstantSolver(ASTFunDecl& decl, const CFG& cfg) :
+        cfg(cfg)
+    {
+        for(auto it = decl.parm_begin(); it != decl.parm_end(); ++it)
+            track_var(**it);
+        track_locals(*decl.get_body());
+    }
+
+    /// Finds the values at the beginning of each executable block.
+    void solve()
+    {
+        this->executable.assign(cfg.size(), false);
+        this->block_env.assign(cfg.size(), Env(tracked_vars.size()));
+
+        // Parameters and uninitialized variables may hold any value.
+        this->executable[cfg.entry()] = true;
+        this->block_env[cfg.entry()].assign(tracked_vars.size(), LatticeValue::bottom());
+
+        std::vector<CFGBlockId> worklist{cfg.entry()};
+        while(!worklist.empty())
+        {
+            const auto id = worklist.back();
+            worklist.pop_back();
+
+            Env env = block_env[id];
+            for(auto succ : transfer(id, env))
+            {
+                if(flow_into(succ, env))
+                    worklist.push_back(succ);
+            }
+        }
+    }
+
+    /// Evaluates each executable block once more, now with the values at
+    /// the fixed point, calling `on_expr(expr, value)` for each evaluated
+    /// expression and `on_branch(block, value)` for each branch.
+    template<typename OnExpr, typename OnBranch>
+    void replay(OnExpr on_expr, OnBranch on_branch)
+    {
+        for(CFGBlockId id = 0; id < cfg.size(); ++id)
+        {
+            if(!executable[id])
+                continue;
+
+            Env env = block_env[id];
+            const auto& block = cfg.block(id);
+            for(auto expr : block.exprs)
+                eval(*expr, env, on_expr);
+
+            if(block.terminator == CFGBlock::Branch)
+                on_branch(block, eval(*block.cond, env, on_expr));
+        }
+    }
+
+private:
+    void track_var(ASTVarDecl& decl)
+    {
+        if(!decl.is_array())
+            this->tracked_vars.emplace(&decl, tracked_vars.size());
+    }
+
+    void track_locals(ASTStmt& stmt)
+    {
+        if(auto comp_stmt = stmt.as_compound_stmt())
+        {
+            for(auto it = comp_stmt->decl_begin(); it != comp_stmt->decl_end(); ++it)
+                track_var(**it);
+            for(auto it = comp_stmt->stmt_begin(); it != comp_stmt->stmt_end(); ++it)
+                track_locals(**it);
+        }
+        else if(auto if_stmt = stmt.as_selection_stmt())
+        {
+            track_locals(*if_stmt->get_then());
+            if(if_stmt->get_else())
+                track_locals(*if_stmt->get_else());
+        }
+        else if(auto while_stmt = stmt.as_iteration_stmt())
+        {
+            track_locals(*while_stmt->get_body());
+        }
+    }
+
+    /// Evaluates a block, updating `env` to the values at its end.
+    ///
+    /// \returns the successors that may be executed next.
+    auto transfer(CFGBlockId id, Env& env) -> std::vector<CFGBlockId>
+    {
+        const auto ignore = [](const ASTExpr&, LatticeValue) {};
+        const auto& block = cfg.block(id);
+
+        for(auto expr : block.exprs)
+            eval(*expr, env, ignore);
+
+        switch(block.terminator)
+        {
+            case CFGBlock::Goto:
+                return block.succs;
+            case CFGBlock::Exit:
+                return {};
+            case CFGBlock::Branch:
+            {
+                const auto cond = eval(*block.cond, env, ignore);
+                if(cond.kind == LatticeValue::Top)
+                    return {};
+                if(cond.kind == LatticeValue::Const)
+                    return {block.succs[cond.value != 0 ? 0 : 1]};
+                return block.succs;
+            }
+            default:
+                cminus_unreachable();
+        }
+    }
+
+    /// Merges the values flowing along an edge into its destination block.
+    ///
+    /// \returns whether the destination block needs to be evaluated again.
+    bool flow_into(CFGBlockId id, const Env& env)
+    {
+        bool changed = !executable[id];
+        this->executable[id] = true;
+
+        auto& dest_env = this->block_env[id];
+        for(size_t i = 0; i < env.size(); ++i)
+        {
+            const auto value = meet(dest_env[i], env[i]);
+            if(value != dest_env[i])
+            {
+                dest_env[i] = value;
+                changed = true;
+            }
+        }
+
+        return changed;
+    }
+
+    /// Evaluates an expression, in the order the generated code would.
+    template<typename OnExpr>
+    auto eval(ASTExpr& expr, Env& env, OnExpr& on_expr) -> LatticeValue
+    {
+        LatticeValue result;
+        switch(expr.expr_kind())
+        {
+            case ExprKind::Number:
+            {
+                result = LatticeValue::constant(static_cast<ASTNumber&>(expr).get_value());
+                break;
+            }
+            case ExprKind::VarRef:
+            {
+                auto& var_ref = static_cast<ASTVarRef&>(expr);
+                if(auto index = var_ref.get_index())
+                {
+                    eval(*index, env, on_expr);
+                    if(auto col_index = var_ref.get_col_index())
+                        eval(*col_index, env, on_expr);
+                    result = LatticeValue::bottom();
+                }
+                else
+                {
+                    auto it = tracked_vars.find(var_ref.get_decl().get());
+                    result = (it != tracked_vars.end() ? env[it->second]
+                                                       : LatticeValue::bottom());
+                }
+                break;
+            }
+            case ExprKind::FunCall:
+            {
+                // Scalar locals cannot be modified by the callee.
+                auto& call = static_cast<ASTFunCall&>(expr);
+                for(auto it = call.arg_begin(); it != call.arg_end(); ++it)
+                    eval(**it, env, on_expr);
+                result = LatticeValue::bottom();
+                break;
+            }
+            case ExprKind::BinaryExpr:
+            {
+                auto& binary = static_cast<ASTBinaryExpr&>(expr);
+                const auto lhs = eval(*binary.get_left(), env, on_expr);
+                const auto rhs = eval(*binary.get_right(), env, on_expr);
+                if(lhs.kind == LatticeValue::Bottom || rhs.kind == LatticeValue::Bottom)
+                    result = LatticeValue::bottom();
+                else if(lhs.kind == LatticeValue::Top || rhs.kind == LatticeValue::Top)
+                    result = LatticeValue{};
+                else
+                    result = fold(binary.get_operation(), lhs.value, rhs.value);
+                break;
+            }
+            case ExprKind::AssignExpr:
+            {
+                auto& assign = static_cast<ASTAssignExpr&>(expr);
+                auto& var_ref = static_cast<ASTVarRef&>(*assign.get_left());
+
+                // The address of the variable is computed before the value.
+                if(auto index = var_ref.get_index())
+                    eval(*index, env, on_expr);
+                if(auto col_index = var_ref.get_col_index())
+                    eval(*col_index, env, on_expr);
+
+                const auto rhs = eval(*assign.get_right(), env, on_expr);
+                auto it = tracked_vars.find(var_ref.get_decl().get());
+                if(it != tracked_vars.end())
+                    env[it->second] = rhs;
+
+                // Not folding the enclosing expressions keeps the store.
+                result = LatticeValue::bottom();
+                break;
+            }
+            case ExprKind::CompoundAssignExpr:
+            {
+                auto& assign = static_cast<ASTCompoundAssignExpr&>(expr);
+                auto& var_ref = *assign.get_var();
+
+                if(auto index = var_ref.get_index())
+                    eval(*index, env, on_expr);
+                if(auto col_index = var_ref.get_col_index())
+                    eval(*col_index, env, on_expr);
+
+                // The variable is read after the right hand side.
+                const auto rhs = eval(*assign.get_right(), env, on_expr);
+                auto it = tracked_vars.find(var_ref.get_decl().get());
+                if(it != tracked_vars.end())
+                {
+                    const auto old_value = env[it->second];
+                    if(old_value.kind == LatticeValue::Bottom || rhs.kind == LatticeValue::Bottom)
+                        env[it->second] = LatticeValue::bottom();
+                    else if(old_value.kind == LatticeValue::Top || rhs.kind == LatticeValue::Top)
+                        env[it->second] = LatticeValue{};
+                    else
+                        env[it->second] = fold(assign.get_operation(), old_value.value, rhs.value);
+                }
+
+                // Not folding the enclosing expressions keeps the update.
+                result = LatticeValue::bottom();
+                break;
+            }
+            default:
+                cminus_unreachable();
+        }
+
+        on_expr(expr, result);
+        return result;
+    }
+
+private:
+    const CFG& cfg;
+
+    /// Maps each tracked variable to its index in an `Env`.
+    std::unordered_map<ASTVarDecl*, size_t> tracked_vars;
+
+    std::vector<bool> executable;
+    std::vector<Env> block_env; //< values at the beginning of each block
+};
+}
+
+namespace cminus
+{
+ConstantPropagation::ConstantPropagation(ASTFunDecl& decl, const CFG& cfg)
+{
+    ConstantSolver solver(decl, cfg);
+    solver.solve();
+
+    const auto on_expr = [this](const ASTExpr& expr, LatticeValue value) {
+        switch(expr.expr_kind())
+        {
+            case ExprKind::VarRef:
+            case ExprKind::BinaryExpr:
+                if(value.kind == LatticeValue::Const)
+                    this->constants.emplace(&expr, value.value);
+                break;
+            default:
+                break;
+        }
+    };
+
+    const auto on_branch = [this](const CFGBlock& block, LatticeValue cond) {
+        if(cond.kind != LatticeValue::Const)
+            return;
+
+        if(auto if_stmt = block.stmt->as_selection_stmt())
+        {
+            auto dead_stmt = (cond.value != 0 ? if_stmt->get_else() : if_stmt->get_then());
+            if(dead_stmt)
+                this->unreachable.insert(dead_stmt.get());
+        }
+        else if(auto while_stmt = block.stmt->as_iteration_stmt())
+        {
+            if(cond.value == 0)
+                this->unreachable.insert(while_stmt->get_body().get());
+        }
+    };
+
+    solver.replay(on_expr, on_branch);
+}
+
+auto ConstantPropagation::get_constant(const ASTExpr& expr) const
+        -> std::optional<int32_t>
+{
+    auto it = constants.find(&expr);
+    if(it == constants.end())
+        return std::nullopt;
+    return it->second;
+}
+
+bool ConstantPropagation::is_unreachable(const ASTStmt& stmt) const
+{
+    return unreachable.count(&stmt) != 0;
+}
+}
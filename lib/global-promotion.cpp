@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cminus/ast-visitor.hpp>
+#include <cminus/global-promotion.hpp>
+
+namespace
+{
+using namespace cminus;
+
+/// Registers promoted variables may be kept in, i.e. `$s0`-`$s7`.
+constexpr uint8_t first_reg = 16;
+constexpr uint8_t max_regs = 8;
+
+/// Collects the accesses to global scalars and the calls made by a loop.
+class LoopAccessCollector : public ASTVisitor
+{
+public:
+    struct Access
+    {
+        ASTVarDecl* var;
+        size_t uses;
+        bool is_modified;
+    };
+
+    explicit LoopAccessCollector(const AliasAnalysis& aliases) :
+        aliases(aliases)
+    {
+    }
+
+    void visit_var_expr(ASTVarRef& var_ref) override
+    {
+        add_use(*var_ref.get_decl(), false);
+        walk_var_expr(var_ref);
+    }
+
+    void visit_call_expr(ASTFunCall& call) override
+    {
+        this->calls.push_back(&call);
+        walk_call_expr(call);
+    }
+
+    void visit_binary_expr(ASTBinaryExpr& expr) override
+    {
+        if(expr.get_operation() != ASTBinaryExpr::Operation::Assign)
+        {
+            walk_binary_expr(expr);
+            return;
+        }
+
+        auto var_ref = expr.get_left()->as_var_expr();
+        add_use(*var_ref->get_decl(), true);
+        if(auto index = var_ref->get_index())
+            visit_expr(*index);
+        if(auto col_index = var_ref->get_col_index())
+            visit_expr(*col_index);
+        visit_expr(*expr.get_right());
+    }
+
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override
+    {
+        add_use(*expr.get_var()->get_decl(), true);
+        walk_compound_assign_expr(expr);
+    }
+
+private:
+    void add_use(ASTVarDecl& var, bool is_store)
+    {
+        if(var.is_array() || !aliases.is_global(var))
+            return;
+
+        auto it = std::find_if(accesses.begin(), accesses.end(),
+                               [&](const Access& access) { return access.var == &var; });
+        if(it == accesses.end())
+            it = accesses.insert(it, Access{&var, 0, false});
+        ++it->uses;
+        it->is_modified |= is_store;
+    }
+
+public:
+    /// The global scalars accessed, in order of first appearance.
+    std::vector<Access> accesses;
+    std::vector<ASTFunCall*> calls;
+
+private:
+    const AliasAnalysis& aliases;
+};
+
+/// Promotes global scalars throughout the loops of a function, outermost
+/// loops first.
+class LoopPromoter : public ASTVisitor
+{
+public:
+    explicit LoopPromoter(
+            const AliasAnalysis& aliases,
+            std::unordered_map<const ASTIterationStmt*, std::vector<PromotedGlobal>>& promoted,
+            uint8_t& num_regs) :
+        aliases(aliases),
+        promoted(promoted),
+        num_regs(num_regs)
+    {
+    }
+
+    void visit_iteration_stmt(ASTIterationStmt& loop) override
+    {
+        LoopAccessCollector collector(aliases);
+        collector.walk_iteration_stmt(loop);
+
+        std::vector<LoopAccessCollector::Access> candidates;
+        for(const auto& access : collector.accesses)
+        {
+            const bool is_enclosed = std::any_of(
+                    enclosing.begin(), enclosing.end(),
+                    [&](const PromotedGlobal& global) { return global.var == access.var; });
+            const bool is_touched = std::any_of(
+                    collector.calls.begin(), collector.calls.end(),
+                    [&](ASTFunCall* call) { return !!aliases.get_mod_ref(*call, *access.var); });
+            if(!is_enclosed && !is_touched)
+                candidates.push_back(access);
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.uses > rhs.uses; });
+
+        const auto outer_size = enclosing.size();
+        auto& loop_promoted = this->promoted[&loop];
+        for(const auto& candidate : candidates)
+        {
+            if(enclosing.size() == max_regs)
+                break;
+
+            const auto reg = static_cast<uint8_t>(first_reg + enclosing.size());
+            const auto global = PromotedGlobal{candidate.var, reg, candidate.is_modified};
+            loop_promoted.push_back(global);
+            this->enclosing.push_back(global);
+        }
+        this->num_regs = std::max(num_regs, static_cast<uint8_t>(enclosing.size()));
+
+        walk_iteration_stmt(loop);
+        this->enclosing.resize(outer_size);
+    }
+
+private:
+    const AliasAnalysis& aliases;
+    std::unordered_map<const ASTIterationStmt*, std::vector<PromotedGlobal>>& promoted;
+    uint8_t& num_regs;
+
+    /// The variables promoted by the loops being visited.
+    std::vector<PromotedGlobal> enclosing;
+};
+}
+
+namespace cminus
+{
+GlobalPromotion::GlobalPromotion(ASTFunDecl& fun, const AliasAnalysis& aliases)
+{
+    LoopPromoter promoter(aliases, this->promoted, this->num_regs);
+    promoter.visit_compound_stmt(*fun.get_body());
+}
+
+auto GlobalPromotion::get_promoted(const ASTIterationStmt& loop) const
+        -> const std::vector<PromotedGlobal>&
+{
+    auto it = promoted.find(&loop);
+    if(it == promoted.end())
+        return none;
+    return it->second;
+}
+}
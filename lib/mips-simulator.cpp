@@ -0,0 +1,1258 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cminus/mips-simulator.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+using namespace cminus;
+using Op = MipsProgram::Op;
+using Instr = MipsProgram::Instr;
+
+/// How the operands of an instruction are written.
+enum class Form : uint8_t
+{
+    None,      //< syscall
+    RdRsRt,    //< addu $d, $s, $t
+    RdRtRs,    //< sllv $d, $t, $s
+    RdRtShamt, //< sll $d, $t, 2
+    RtRsImm,   //< addiu $t, $s, 4
+    RtImm,     //< lui $t, 4
+    RdRs,      //< move $d, $s
+    RdRt,      //< neg $d, $t (i.e. sub $d, $0, $t)
+    RsRt,      //< mult $s, $t
+    Rd,        //< mflo $d
+    Rs,        //< jr $s
+    RtAddr,    //< la $t, label
+    Mem,       //< lw $t, 4($s) or lw $t, label
+    RsRtLabel, //< beq $s, $t, label
+    RsLabel,   //< bltz $s, label
+    Label,     //< j label
+};
+
+struct Mnemonic
+{
+    std::string_view name;
+    Op op;
+    Form form;
+};
+
+constexpr Mnemonic mnemonics[] = {
+        {"add", Op::Add, Form::RdRsRt},
+        {"addu", Op::Addu, Form::RdRsRt},
+        {"sub", Op::Sub, Form::RdRsRt},
+        {"subu", Op::Subu, Form::RdRsRt},
+        {"and", Op::And, Form::RdRsRt},
+        {"or", Op::Or, Form::RdRsRt},
+        {"xor", Op::Xor, Form::RdRsRt},
+        {"nor", Op::Nor, Form::RdRsRt},
+        {"slt", Op::Slt, Form::RdRsRt},
+        {"sltu", Op::Sltu, Form::RdRsRt},
+        {"sllv", Op::Sllv, Form::RdRtRs},
+        {"srlv", Op::Srlv, Form::RdRtRs},
+        {"srav", Op::Srav, Form::RdRtRs},
+        {"mul", Op::Mul, Form::RdRsRt},
+        {"sll", Op::Sll, Form::RdRtShamt},
+        {"srl", Op::Srl, Form::RdRtShamt},
+        {"sra", Op::Sra, Form::RdRtShamt},
+        {"addi", Op::Addi, Form::RtRsImm},
+        {"addiu", Op::Addiu, Form::RtRsImm},
+        {"andi", Op::Andi, Form::RtRsImm},
+        {"ori", Op::Ori, Form::RtRsImm},
+        {"xori", Op::Xori, Form::RtRsImm},
+        {"slti", Op::Slti, Form::RtRsImm},
+        {"sltiu", Op::Sltiu, Form::RtRsImm},
+        {"lui", Op::Lui, Form::RtImm},
+        {"li", Op::Li, Form::RtImm},
+        {"la", Op::Li, Form::RtAddr},
+        {"move", Op::Move, Form::RdRs},
+        {"not", Op::Nor, Form::RdRs},
+        {"neg", Op::Sub, Form::RdRt},
+        {"negu", Op::Subu, Form::RdRt},
+        {"mult", Op::Mult, Form::RsRt},
+        {"multu", Op::Multu, Form::RsRt},
+        {"div", Op::Div, Form::RsRt},
+        {"divu", Op::Divu, Form::RsRt},
+        {"mfhi", Op::Mfhi, Form::Rd},
+        {"mflo", Op::Mflo, Form::Rd},
+        {"mthi", Op::Mthi, Form::Rs},
+        {"mtlo", Op::Mtlo, Form::Rs},
+        {"lw", Op::Lw, Form::Mem},
+        {"lh", Op::Lh, Form::Mem},
+        {"lhu", Op::Lhu, Form::Mem},
+        {"lb", Op::Lb, Form::Mem},
+        {"lbu", Op::Lbu, Form::Mem},
+        {"sw", Op::Sw, Form::Mem},
+        {"sh", Op::Sh, Form::Mem},
+        {"sb", Op::Sb, Form::Mem},
+        {"beq", Op::Beq, Form::RsRtLabel},
+        {"bne", Op::Bne, Form::RsRtLabel},
+        {"blt", Op::Blt, Form::RsRtLabel},
+        {"ble", Op::Ble, Form::RsRtLabel},
+        {"bgt", Op::Bgt, Form::RsRtLabel},
+        {"bge", Op::Bge, Form::RsRtLabel},
+        {"beqz", Op::Beq, Form::RsLabel},
+        {"bnez", Op::Bne, Form::RsLabel},
+        {"blez", Op::Blez, Form::RsLabel},
+        {"bgtz", Op::Bgtz, Form::RsLabel},
+        {"bltz", Op::Bltz, Form::RsLabel},
+        {"bgez", Op::Bgez, Form::RsLabel},
+        {"bltzal", Op::Bltzal, Form::RsLabel},
+        {"bgezal", Op::Bgezal, Form::RsLabel},
+        {"b", Op::J, Form::Label},
+        {"j", Op::J, Form::Label},
+        {"jal", Op::Jal, Form::Label},
+        {"jr", Op::Jr, Form::Rs},
+        {"jalr", Op::Jalr, Form::Rs},
+        {"syscall", Op::Syscall, Form::None},
+        {"break", Op::Break, Form::None},
+        {"nop", Op::Nop, Form::None},
+};
+
+constexpr std::string_view register_names[] = {
+        "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+        "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+        "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+        "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra",
+};
+
+constexpr uint8_t REG_V0 = 2;
+constexpr uint8_t REG_A0 = 4;
+constexpr uint8_t REG_A1 = 5;
+constexpr uint8_t REG_A2 = 6;
+constexpr uint8_t REG_GP = 28;
+constexpr uint8_t REG_SP = 29;
+constexpr uint8_t REG_RA = 31;
+
+auto trim(std::string_view text) -> std::string_view
+{
+    while(!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+        text.remove_prefix(1);
+    while(!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+        text.remove_suffix(1);
+    return text;
+}
+
+bool is_label_char(char c, bool first)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '.'
+           || c == '$' || (!first && std::isdigit(static_cast<unsigned char>(c)));
+}
+
+/// Splits the operands of an instruction or directive, which are separated
+/// by commas outside of string literals.
+auto split_operands(std::string_view text) -> std::vector<std::string_view>
+{
+    std::vector<std::string_view> operands;
+    if(trim(text).empty())
+        return operands;
+
+    bool in_string = false;
+    size_t begin = 0;
+    for(size_t i = 0; i < text.size(); ++i)
+    {
+        if(text[i] == '"' && (i == 0 || text[i - 1] != '\\'))
+            in_string = !in_string;
+        else if(text[i] == ',' && !in_string)
+        {
+            operands.push_back(trim(text.substr(begin, i - begin)));
+            begin = i + 1;
+        }
+    }
+    operands.push_back(trim(text.substr(begin)));
+    return operands;
+}
+
+/// \returns the line without its comment, if any.
+auto strip_comment(std::string_view line) -> std::string_view
+{
+    bool in_string = false;
+    for(size_t i = 0; i < line.size(); ++i)
+    {
+        if(line[i] == '"' && (i == 0 || line[i - 1] != '\\'))
+            in_string = !in_string;
+        else if(line[i] == '#' && !in_string)
+            return line.substr(0, i);
+    }
+    return line;
+}
+
+auto parse_number(std::string_view text) -> std::optional<int64_t>
+{
+    text = trim(text);
+    if(text.size() == 3 && text.front() == '\'' && text.back() == '\'')
+        return text[1];
+
+    std::string buffer(text);
+    char* end;
+    errno = 0;
+    const auto value = std::strtoll(buffer.c_str(), &end, 0);
+    if(buffer.empty() || *end != '\0' || errno != 0)
+        return std::nullopt;
+    return value;
+}
+
+auto parse_register(std::string_view text) -> std::optional<uint8_t>
+{
+    text = trim(text);
+    if(text.size() < 2 || text.front() != '$')
+        return std::nullopt;
+
+    text.remove_prefix(1);
+    if(std::isdigit(static_cast<unsigned char>(text.front())))
+    {
+        auto number = parse_number(text);
+        if(!number || *number < 0 || *number > 31)
+            return std::nullopt;
+        return static_cast<uint8_t>(*number);
+    }
+
+    if(text == "s8")
+        return 30;
+    for(size_t i = 0; i < std::size(register_names); ++i)
+    {
+        if(register_names[i] == text)
+            return static_cast<uint8_t>(i);
+    }
+    return std::nullopt;
+}
+
+/// Assembles a program in two passes: the first lays out the segments and
+/// defines the labels, the second resolves the references to labels.
+class Assembler
+{
+public:
+    explicit Assembler(std::string& error) :
+        error(error)
+    {
+    }
+
+    bool run(std::string_view source)
+    {
+        size_t line_number = 0;
+        while(!source.empty())
+        {
+            ++line_number;
+            const auto newline = source.find('\n');
+            auto line = source.substr(0, newline);
+            source.remove_prefix(newline == source.npos ? source.size() : newline + 1);
+
+            if(!assemble_line(trim(strip_comment(line))))
+            {
+                this->error = "line " + std::to_string(line_number) + ": " + error;
+                return false;
+            }
+        }
+        return resolve();
+    }
+
+    std::vector<Instr> text;
+    std::vector<uint8_t> data;
+    size_t entry = 0;
+
+private:
+    struct Fixup
+    {
+        enum Kind : uint8_t
+        {
+            Data,    //< a word in the data segment holds the address
+            Address, //< the immediate of an instruction holds the address
+            Target,  //< the immediate of an instruction holds the index
+        };
+
+        Kind kind;
+        size_t where; //< instruction index or data offset
+        std::string label;
+        int32_t addend = 0;
+    };
+
+    bool assemble_line(std::string_view line)
+    {
+        // Labels come first.
+        while(!line.empty() && is_label_char(line.front(), true))
+        {
+            size_t end = 1;
+            while(end < line.size() && is_label_char(line[end], false))
+                ++end;
+
+            auto rest = trim(line.substr(end));
+            if(rest.empty() || rest.front() != ':')
+                break;
+
+            if(!define_label(line.substr(0, end)))
+                return false;
+            line = trim(rest.substr(1));
+        }
+
+        if(line.empty())
+            return true;
+
+        const auto space = line.find_first_of(" \t");
+        const auto name = line.substr(0, space);
+        const auto operands = split_operands(space == line.npos ? "" : line.substr(space));
+
+        if(name.front() == '.')
+            return assemble_directive(name, operands);
+        return assemble_instruction(name, operands);
+    }
+
+    bool define_label(std::string_view name)
+    {
+        const auto address = in_text ? MipsProgram::text_base + 4 * text.size()
+                                     : MipsProgram::data_base + data.size();
+        if(!labels.emplace(name, Label{static_cast<uint32_t>(address), in_text}).second)
+            return fail("label " + std::string(name) + " defined twice");
+        return true;
+    }
+
+    bool assemble_directive(std::string_view name, const std::vector<std::string_view>& operands)
+    {
+        if(name == ".text")
+        {
+            this->in_text = true;
+            return true;
+        }
+        else if(name == ".data")
+        {
+            this->in_text = false;
+            return true;
+        }
+        else if(name == ".align" || name == ".space" || name == ".word"
+                || name == ".half" || name == ".byte" || name == ".ascii"
+                || name == ".asciiz")
+        {
+            if(in_text)
+                return name == ".align" || fail("data directive in the text segment");
+            return assemble_data(name, operands);
+        }
+
+        // Anything else (e.g. .globl) does not affect the program.
+        return true;
+    }
+
+    bool assemble_data(std::string_view name, const std::vector<std::string_view>& operands)
+    {
+        if(name == ".ascii" || name == ".asciiz")
+        {
+            for(auto operand : operands)
+            {
+                if(!assemble_string(operand))
+                    return false;
+                if(name == ".asciiz")
+                    this->data.push_back(0);
+            }
+            return true;
+        }
+
+        if(operands.empty())
+            return fail("missing operand");
+
+        if(name == ".align" || name == ".space")
+        {
+            auto value = parse_number(operands[0]);
+            if(!value || *value < 0 || (name == ".align" && *value > 12))
+                return fail("bad operand " + std::string(operands[0]));
+
+            if(name == ".align")
+                align(size_t(1) << *value);
+            else
+                this->data.resize(data.size() + *value);
+            return true;
+        }
+
+        const size_t size = (name == ".word" ? 4 : name == ".half" ? 2 : 1);
+        align(size);
+        for(auto operand : operands)
+        {
+            int32_t value = 0;
+            if(auto number = parse_number(operand))
+                value = static_cast<int32_t>(*number);
+            else if(size == 4 && is_label_char(operand.front(), true))
+                this->fixups.push_back(Fixup{Fixup::Data, data.size(), std::string(operand)});
+            else
+                return fail("bad operand " + std::string(operand));
+
+            for(size_t i = 0; i < size; ++i)
+                this->data.push_back(static_cast<uint8_t>(uint32_t(value) >> (8 * i)));
+        }
+        return true;
+    }
+
+    bool assemble_string(std::string_view operand)
+    {
+        if(operand.size() < 2 || operand.front() != '"' || operand.back() != '"')
+            return fail("bad string " + std::string(operand));
+
+        operand = operand.substr(1, operand.size() - 2);
+        for(size_t i = 0; i < operand.size(); ++i)
+        {
+            char c = operand[i];
+            if(c == '\\' && i + 1 < operand.size())
+            {
+                switch(operand[++i])
+                {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case '0':
+                        c = '\0';
+                        break;
+                    default:
+                        c = operand[i];
+                        break;
+                }
+            }
+            this->data.push_back(static_cast<uint8_t>(c));
+        }
+        return true;
+    }
+
+    void align(size_t alignment)
+    {
+        this->data.resize((data.size() + alignment - 1) / alignment * alignment);
+    }
+
+    bool assemble_instruction(std::string_view name, const std::vector<std::string_view>& operands)
+    {
+        if(!in_text)
+            return fail("instruction in the data segment");
+
+        const Mnemonic* mnemonic = nullptr;
+        for(const auto& candidate : mnemonics)
+        {
+            if(candidate.name == name)
+                mnemonic = &candidate;
+        }
+
+        if(mnemonic == nullptr)
+            return fail("unknown instruction " + std::string(name));
+
+        static constexpr size_t num_operands[] = {
+                0, // None
+                3, // RdRsRt
+                3, // RdRtRs
+                3, // RdRtShamt
+                3, // RtRsImm
+                2, // RtImm
+                2, // RdRs
+                2, // RdRt
+                2, // RsRt
+                1, // Rd
+                1, // Rs
+                2, // RtAddr
+                2, // Mem
+                3, // RsRtLabel
+                2, // RsLabel
+                1, // Label
+        };
+
+        if(operands.size() != num_operands[static_cast<size_t>(mnemonic->form)])
+            return fail("wrong number of operands for " + std::string(name));
+
+        Instr instr;
+        instr.op = mnemonic->op;
+
+        bool ok = true;
+        auto reg = [&](std::string_view operand, uint8_t& dest) {
+            if(auto number = parse_register(operand))
+                dest = *number;
+            else
+                ok = fail("bad register " + std::string(operand));
+        };
+        auto imm = [&](std::string_view operand) {
+            auto number = parse_number(operand);
+            if(number && *number >= INT32_MIN && *number <= UINT32_MAX)
+                instr.imm = static_cast<int32_t>(*number);
+            else
+                ok = fail("bad immediate " + std::string(operand));
+        };
+        auto label = [&](std::string_view operand, bool is_target) {
+            ok = add_fixup(operand, is_target);
+        };
+
+        switch(mnemonic->form)
+        {
+            case Form::None:
+                break;
+            case Form::RdRsRt:
+                reg(operands[0], instr.rd);
+                reg(operands[1], instr.rs);
+                reg(operands[2], instr.rt);
+                break;
+            case Form::RdRtRs:
+                reg(operands[0], instr.rd);
+                reg(operands[1], instr.rt);
+                reg(operands[2], instr.rs);
+                break;
+            case Form::RdRtShamt:
+                reg(operands[0], instr.rd);
+                reg(operands[1], instr.rt);
+                imm(operands[2]);
+                break;
+            case Form::RtRsImm:
+                reg(operands[0], instr.rt);
+                reg(operands[1], instr.rs);
+                imm(operands[2]);
+                break;
+            case Form::RtImm:
+                reg(operands[0], instr.rt);
+                imm(operands[1]);
+                break;
+            case Form::RdRs:
+                reg(operands[0], instr.rd);
+                reg(operands[1], instr.rs);
+                break;
+            case Form::RdRt:
+                reg(operands[0], instr.rd);
+                reg(operands[1], instr.rt);
+                break;
+            case Form::RsRt:
+                reg(operands[0], instr.rs);
+                reg(operands[1], instr.rt);
+                break;
+            case Form::Rd:
+                reg(operands[0], instr.rd);
+                break;
+            case Form::Rs:
+                reg(operands[0], instr.rs);
+                break;
+            case Form::RtAddr:
+                reg(operands[0], instr.rt);
+                label(operands[1], false);
+                break;
+            case Form::Mem:
+                reg(operands[0], instr.rt);
+                if(ok)
+                    ok = assemble_address(operands[1], instr);
+                break;
+            case Form::RsRtLabel:
+                reg(operands[0], instr.rs);
+                reg(operands[1], instr.rt);
+                label(operands[2], true);
+                break;
+            case Form::RsLabel:
+                reg(operands[0], instr.rs);
+                label(operands[1], true);
+                break;
+            case Form::Label:
+                label(operands[0], true);
+                break;
+        }
+
+        if(!ok)
+            return false;
+
+        this->text.push_back(instr);
+        return true;
+    }
+
+    /// Assembles a memory operand, such as `4($sp)`, `label` or `label+4($t0)`.
+    bool assemble_address(std::string_view operand, Instr& instr)
+    {
+        if(auto paren = operand.find('('); paren != operand.npos)
+        {
+            if(operand.back() != ')')
+                return fail("bad address " + std::string(operand));
+
+            auto base = parse_register(operand.substr(paren + 1, operand.size() - paren - 2));
+            if(!base)
+                return fail("bad address " + std::string(operand));
+
+            instr.rs = *base;
+            operand = trim(operand.substr(0, paren));
+            if(operand.empty())
+                return true;
+        }
+
+        if(auto number = parse_number(operand))
+        {
+            instr.imm = static_cast<int32_t>(*number);
+            return true;
+        }
+        return add_fixup(operand, false);
+    }
+
+    /// Adds a reference to `label`, `label+N` or `label-N` from the
+    /// instruction about to be added.
+    bool add_fixup(std::string_view operand, bool is_target)
+    {
+        int32_t addend = 0;
+        if(auto sign = operand.find_first_of("+-"); sign != operand.npos && !is_target)
+        {
+            auto number = parse_number(operand.substr(sign + 1));
+            if(!number)
+                return fail("bad address " + std::string(operand));
+            addend = static_cast<int32_t>(operand[sign] == '-' ? -*number : *number);
+            operand = trim(operand.substr(0, sign));
+        }
+
+        if(operand.empty() || !is_label_char(operand.front(), true))
+            return fail("bad label " + std::string(operand));
+
+        const auto kind = is_target ? Fixup::Target : Fixup::Address;
+        this->fixups.push_back(Fixup{kind, text.size(), std::string(operand), addend});
+        return true;
+    }
+
+    bool resolve()
+    {
+        for(const auto& fixup : fixups)
+        {
+            auto it = labels.find(fixup.label);
+            if(it == labels.end())
+                return fail("undefined label " + fixup.label);
+
+            const auto& label = it->second;
+            switch(fixup.kind)
+            {
+                case Fixup::Data:
+                    for(size_t i = 0; i < 4; ++i)
+                        this->data[fixup.where + i] = static_cast<uint8_t>(label.address >> (8 * i));
+                    break;
+                case Fixup::Address:
+                    this->text[fixup.where].imm = label.address + fixup.addend;
+                    break;
+                case Fixup::Target:
+                    if(!label.in_text)
+                        return fail("branch to data label " + fixup.label);
+                    this->text[fixup.where].imm = (label.address - MipsProgram::text_base) / 4;
+                    break;
+            }
+        }
+
+        auto main = labels.find("main");
+        if(main == labels.end() || !main->second.in_text)
+            return fail("no main function");
+        this->entry = (main->second.address - MipsProgram::text_base) / 4;
+        return true;
+    }
+
+    bool fail(std::string message)
+    {
+        this->error = std::move(message);
+        return false;
+    }
+
+private:
+    struct Label
+    {
+        uint32_t address;
+        bool in_text;
+    };
+
+    std::string& error;
+    bool in_text = true;
+    std::unordered_map<std::string, Label> labels;
+    std::vector<Fixup> fixups;
+};
+
+/// The state of a running program.
+class Machine
+{
+public:
+    explicit Machine(const MipsProgram& program,
+                     std::string_view input,
+                     const SimulationLimits& limits) :
+        program(program),
+        input(input),
+        limits(limits)
+    {
+    }
+
+    auto run() -> SimulationResult
+    {
+        const auto& text = program.instructions();
+        const auto& data = program.data_segment();
+        for(size_t i = 0; i < data.size(); ++i)
+        {
+            if(data[i] != 0 && !store(MipsProgram::data_base + i, 1, data[i]))
+                return std::move(result);
+        }
+
+        this->heap_end = (MipsProgram::data_base + data.size() + 7) & ~uint32_t(7);
+        this->regs[REG_GP] = 0x10008000;
+        this->regs[REG_SP] = 0x7fffeffc;
+
+        // Returning from main jumps right past the last instruction.
+        this->regs[REG_RA] = MipsProgram::text_base + 4 * text.size();
+
+        size_t pc = program.entry();
+        while(pc < text.size())
+        {
+            if(result.instructions == limits.max_instructions)
+            {
+                stop(ExitReason::InstructionBudget);
+                return std::move(result);
+            }
+            ++this->result.instructions;
+
+            const auto& instr = text[pc];
+            const auto rs = regs[instr.rs];
+            const auto rt = regs[instr.rt];
+            const auto imm = static_cast<uint32_t>(instr.imm);
+            auto next_pc = pc + 1;
+            uint32_t value;
+
+            switch(instr.op)
+            {
+                case Op::Add:
+                    value = rs + rt;
+                    if(add_overflows(rs, rt, value))
+                    {
+                        fault("arithmetic overflow");
+                        return std::move(result);
+                    }
+                    set(instr.rd, value);
+                    break;
+                case Op::Addu:
+                    set(instr.rd, rs + rt);
+                    break;
+                case Op::Sub:
+                    value = rs - rt;
+                    if(sub_overflows(rs, rt, value))
+                    {
+                        fault("arithmetic overflow");
+                        return std::move(result);
+                    }
+                    set(instr.rd, value);
+                    break;
+                case Op::Subu:
+                    set(instr.rd, rs - rt);
+                    break;
+                case Op::And:
+                    set(instr.rd, rs & rt);
+                    break;
+                case Op::Or:
+                    set(instr.rd, rs | rt);
+                    break;
+                case Op::Xor:
+                    set(instr.rd, rs ^ rt);
+                    break;
+                case Op::Nor:
+                    set(instr.rd, ~(rs | rt));
+                    break;
+                case Op::Slt:
+                    set(instr.rd, int32_t(rs) < int32_t(rt));
+                    break;
+                case Op::Sltu:
+                    set(instr.rd, rs < rt);
+                    break;
+                case Op::Sllv:
+                    set(instr.rd, rt << (rs & 31));
+                    break;
+                case Op::Srlv:
+                    set(instr.rd, rt >> (rs & 31));
+                    break;
+                case Op::Srav:
+                    set(instr.rd, shift_right_arithmetic(rt, rs & 31));
+                    break;
+                case Op::Mul:
+                    set(instr.rd, rs * rt);
+                    break;
+                case Op::Sll:
+                    set(instr.rd, rt << (imm & 31));
+                    break;
+                case Op::Srl:
+                    set(instr.rd, rt >> (imm & 31));
+                    break;
+                case Op::Sra:
+                    set(instr.rd, shift_right_arithmetic(rt, imm & 31));
+                    break;
+                case Op::Addi:
+                    value = rs + imm;
+                    if(add_overflows(rs, imm, value))
+                    {
+                        fault("arithmetic overflow");
+                        return std::move(result);
+                    }
+                    set(instr.rt, value);
+                    break;
+                case Op::Addiu:
+                    set(instr.rt, rs + imm);
+                    break;
+                case Op::Andi:
+                    set(instr.rt, rs & (imm & 0xffff));
+                    break;
+                case Op::Ori:
+                    set(instr.rt, rs | (imm & 0xffff));
+                    break;
+                case Op::Xori:
+                    set(instr.rt, rs ^ (imm & 0xffff));
+                    break;
+                case Op::Slti:
+                    set(instr.rt, int32_t(rs) < int32_t(imm));
+                    break;
+                case Op::Sltiu:
+                    set(instr.rt, rs < imm);
+                    break;
+                case Op::Lui:
+                    set(instr.rt, imm << 16);
+                    break;
+                case Op::Li:
+                    set(instr.rt, imm);
+                    break;
+                case Op::Move:
+                    set(instr.rd, rs);
+                    break;
+                case Op::Mult:
+                {
+                    const auto product = int64_t(int32_t(rs)) * int32_t(rt);
+                    this->lo = static_cast<uint32_t>(product);
+                    this->hi = static_cast<uint32_t>(uint64_t(product) >> 32);
+                    break;
+                }
+                case Op::Multu:
+                {
+                    const auto product = uint64_t(rs) * rt;
+                    this->lo = static_cast<uint32_t>(product);
+                    this->hi = static_cast<uint32_t>(product >> 32);
+                    break;
+                }
+                case Op::Div:
+                    if(rt != 0 && !(int32_t(rs) == INT32_MIN && int32_t(rt) == -1))
+                    {
+                        this->lo = static_cast<uint32_t>(int32_t(rs) / int32_t(rt));
+                        this->hi = static_cast<uint32_t>(int32_t(rs) % int32_t(rt));
+                    }
+                    else if(rt != 0)
+                    {
+                        this->lo = rs;
+                        this->hi = 0;
+                    }
+                    break;
+                case Op::Divu:
+                    if(rt != 0)
+                    {
+                        this->lo = rs / rt;
+                        this->hi = rs % rt;
+                    }
+                    break;
+                case Op::Mfhi:
+                    set(instr.rd, hi);
+                    break;
+                case Op::Mflo:
+                    set(instr.rd, lo);
+                    break;
+                case Op::Mthi:
+                    this->hi = rs;
+                    break;
+                case Op::Mtlo:
+                    this->lo = rs;
+                    break;
+                case Op::Lw:
+                case Op::Lh:
+                case Op::Lhu:
+                case Op::Lb:
+                case Op::Lbu:
+                {
+                    const auto size = (instr.op == Op::Lw ? 4 : instr.op == Op::Lb || instr.op == Op::Lbu ? 1 : 2);
+                    if(!load(rs + imm, size, value))
+                        return std::move(result);
+                    if(instr.op == Op::Lh)
+                        value = static_cast<uint32_t>(int32_t(int16_t(value)));
+                    else if(instr.op == Op::Lb)
+                        value = static_cast<uint32_t>(int32_t(int8_t(value)));
+                    set(instr.rt, value);
+                    break;
+                }
+                case Op::Sw:
+                case Op::Sh:
+                case Op::Sb:
+                {
+                    const auto size = (instr.op == Op::Sw ? 4 : instr.op == Op::Sh ? 2 : 1);
+                    if(!store(rs + imm, size, rt))
+                        return std::move(result);
+                    break;
+                }
+                case Op::Beq:
+                    if(rs == rt)
+                        next_pc = imm;
+                    break;
+                case Op::Bne:
+                    if(rs != rt)
+                        next_pc = imm;
+                    break;
+                case Op::Blt:
+                    if(int32_t(rs) < int32_t(rt))
+                        next_pc = imm;
+                    break;
+                case Op::Ble:
+                    if(int32_t(rs) <= int32_t(rt))
+                        next_pc = imm;
+                    break;
+                case Op::Bgt:
+                    if(int32_t(rs) > int32_t(rt))
+                        next_pc = imm;
+                    break;
+                case Op::Bge:
+                    if(int32_t(rs) >= int32_t(rt))
+                        next_pc = imm;
+                    break;
+                case Op::Blez:
+                    if(int32_t(rs) <= 0)
+                        next_pc = imm;
+                    break;
+                case Op::Bgtz:
+                    if(int32_t(rs) > 0)
+                        next_pc = imm;
+                    break;
+                case Op::Bltz:
+                    if(int32_t(rs) < 0)
+                        next_pc = imm;
+                    break;
+                case Op::Bgez:
+                    if(int32_t(rs) >= 0)
+                        next_pc = imm;
+                    break;
+                case Op::Bltzal:
+                    set(REG_RA, return_address(pc));
+                    if(int32_t(rs) < 0)
+                        next_pc = imm;
+                    break;
+                case Op::Bgezal:
+                    set(REG_RA, return_address(pc));
+                    if(int32_t(rs) >= 0)
+                        next_pc = imm;
+                    break;
+                case Op::J:
+                    next_pc = imm;
+                    break;
+                case Op::Jal:
+                    set(REG_RA, return_address(pc));
+                    next_pc = imm;
+                    break;
+                case Op::Jr:
+                case Op::Jalr:
+                    if(rs < MipsProgram::text_base || rs % 4 != 0
+                       || (rs - MipsProgram::text_base) / 4 > text.size())
+                    {
+                        fault("jump to bad address " + hex(rs));
+                        return std::move(result);
+                    }
+                    if(instr.op == Op::Jalr)
+                        set(REG_RA, return_address(pc));
+                    next_pc = (rs - MipsProgram::text_base) / 4;
+                    break;
+                case Op::Syscall:
+                    if(!syscall())
+                        return std::move(result);
+                    break;
+                case Op::Break:
+                    fault("break");
+                    return std::move(result);
+                case Op::Nop:
+                    break;
+            }
+
+            pc = next_pc;
+        }
+
+        stop(ExitReason::Exit);
+        return std::move(result);
+    }
+
+private:
+    static constexpr uint32_t page_size = 4096;
+
+    static auto shift_right_arithmetic(uint32_t value, uint32_t amount) -> uint32_t
+    {
+        return int32_t(value) < 0 ? ~(~value >> amount) : value >> amount;
+    }
+
+    static auto return_address(size_t pc) -> uint32_t
+    {
+        return static_cast<uint32_t>(MipsProgram::text_base + 4 * (pc + 1));
+    }
+
+    static auto hex(uint32_t value) -> std::string
+    {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "0x%08x", value);
+        return buffer;
+    }
+
+    void set(uint8_t reg, uint32_t value)
+    {
+        if(reg != 0)
+            this->regs[reg] = value;
+    }
+
+    void stop(ExitReason reason)
+    {
+        this->result.reason = reason;
+    }
+
+    /// \returns whether `lhs + rhs`, which gave `sum`, overflows as signed
+    /// integers.
+    static bool add_overflows(uint32_t lhs, uint32_t rhs, uint32_t sum)
+    {
+        return ((lhs ^ sum) & (rhs ^ sum)) >> 31;
+    }
+
+    /// \returns whether `lhs - rhs`, which gave `difference`, overflows as
+    /// signed integers.
+    static bool sub_overflows(uint32_t lhs, uint32_t rhs, uint32_t difference)
+    {
+        return ((lhs ^ rhs) & (lhs ^ difference)) >> 31;
+    }
+
+    void fault(std::string message)
+    {
+        this->result.fault = std::move(message);
+        stop(ExitReason::Fault);
+    }
+
+    /// \returns the page holding an address or null if the page was never
+    /// written to. Allocates the page if `allocate`, which may run out of
+    /// memory, in which case the program stops.
+    auto find_page(uint32_t address, bool allocate, bool& out_of_memory) -> uint8_t*
+    {
+        const auto number = address / page_size;
+        if(last_page && last_page_number == number)
+            return last_page;
+
+        auto it = pages.find(number);
+        if(it == pages.end())
+        {
+            if(!allocate)
+                return nullptr;
+
+            if((pages.size() + 1) * page_size > limits.max_memory)
+            {
+                out_of_memory = true;
+                return nullptr;
+            }
+            it = pages.emplace(number, std::make_unique<uint8_t[]>(page_size)).first;
+        }
+
+        this->last_page = it->second.get();
+        this->last_page_number = number;
+        return last_page;
+    }
+
+    bool check_address(uint32_t address, unsigned size)
+    {
+        if(address % size != 0)
+        {
+            fault("unaligned access to " + hex(address));
+            return false;
+        }
+        if(address < 0x10000000 || address >= 0x80000000)
+        {
+            fault("access to bad address " + hex(address));
+            return false;
+        }
+        return true;
+    }
+
+    bool load(uint32_t address, unsigned size, uint32_t& value)
+    {
+        if(!check_address(address, size))
+            return false;
+
+        bool out_of_memory = false;
+        auto page = find_page(address, false, out_of_memory);
+        value = 0;
+        if(page != nullptr)
+        {
+            for(unsigned i = 0; i < size; ++i)
+                value |= uint32_t(page[address % page_size + i]) << (8 * i);
+        }
+        return true;
+    }
+
+    bool store(uint32_t address, unsigned size, uint32_t value)
+    {
+        if(!check_address(address, size))
+            return false;
+
+        bool out_of_memory = false;
+        auto page = find_page(address, true, out_of_memory);
+        if(out_of_memory)
+        {
+            stop(ExitReason::MemoryBudget);
+            return false;
+        }
+
+        for(unsigned i = 0; i < size; ++i)
+            page[address % page_size + i] = static_cast<uint8_t>(value >> (8 * i));
+        return true;
+    }
+
+    /// Reads a line of the input, including its newline.
+    auto read_line() -> std::string_view
+    {
+        const auto newline = input.find('\n');
+        const auto line = input.substr(0, newline == input.npos ? input.size() : newline + 1);
+        this->input.remove_prefix(line.size());
+        return line;
+    }
+
+    /// Converts a line into an integer as `atol` does.
+    static auto line_to_int(std::string_view line) -> uint32_t
+    {
+        size_t i = 0;
+        while(i < line.size() && std::isspace(static_cast<unsigned char>(line[i])))
+            ++i;
+
+        bool negative = false;
+        if(i < line.size() && (line[i] == '-' || line[i] == '+'))
+            negative = (line[i++] == '-');
+
+        uint32_t value = 0;
+        for(; i < line.size() && std::isdigit(static_cast<unsigned char>(line[i])); ++i)
+            value = value * 10 + (line[i] - '0');
+        return negative ? -value : value;
+    }
+
+    /// Performs the syscall requested in `$v0`.
+    ///
+    /// \returns whether the program goes on.
+    bool syscall()
+    {
+        const auto a0 = regs[REG_A0];
+        const auto a1 = regs[REG_A1];
+        const auto a2 = regs[REG_A2];
+        uint32_t value;
+
+        switch(regs[REG_V0])
+        {
+            case 1: // print_int
+                this->result.output += std::to_string(int32_t(a0));
+                break;
+            case 4: // print_string
+                for(auto address = a0;; ++address)
+                {
+                    if(!load(address, 1, value))
+                        return false;
+                    if(value == 0)
+                        break;
+                    this->result.output.push_back(static_cast<char>(value));
+                }
+                break;
+            case 5: // read_int
+                set(REG_V0, line_to_int(read_line()));
+                break;
+            case 8: // read_string
+            {
+                const auto line = read_line();
+                const auto length = std::min<size_t>(line.size(), a1 > 0 ? a1 - 1 : 0);
+                for(size_t i = 0; i < length; ++i)
+                {
+                    if(!store(a0 + i, 1, line[i]))
+                        return false;
+                }
+                if(a1 > 0 && !store(a0 + length, 1, 0))
+                    return false;
+                break;
+            }
+            case 9: // sbrk
+                set(REG_V0, heap_end);
+                this->heap_end = (heap_end + a0 + 7) & ~uint32_t(7);
+                break;
+            case 10: // exit
+            case 17: // exit2
+                stop(ExitReason::Exit);
+                return false;
+            case 11: // print_char
+                this->result.output.push_back(static_cast<char>(a0));
+                break;
+            case 12: // read_char
+                set(REG_V0, input.empty() ? 0 : uint8_t(input.front()));
+                this->input.remove_prefix(input.empty() ? 0 : 1);
+                break;
+            case 13: // open
+                set(REG_V0, -1);
+                break;
+            case 14: // read
+            {
+                if(a0 != 0)
+                {
+                    set(REG_V0, -1);
+                    break;
+                }
+
+                const auto length = std::min<size_t>(input.size(), a2);
+                for(size_t i = 0; i < length; ++i)
+                {
+                    if(!store(a1 + i, 1, input[i]))
+                        return false;
+                }
+                this->input.remove_prefix(length);
+                set(REG_V0, length);
+                break;
+            }
+            case 15: // write
+            {
+                if(a0 != 1 && a0 != 2)
+                {
+                    set(REG_V0, -1);
+                    break;
+                }
+
+                for(uint32_t i = 0; i < a2; ++i)
+                {
+                    if(!load(a1 + i, 1, value))
+                        return false;
+                    this->result.output.push_back(static_cast<char>(value));
+                }
+                set(REG_V0, a2);
+                break;
+            }
+            case 16: // close
+                set(REG_V0, -1);
+                break;
+            default:
+                fault("unknown syscall " + std::to_string(regs[REG_V0]));
+                return false;
+        }
+        return true;
+    }
+
+private:
+    const MipsProgram& program;
+    std::string_view input;
+    const SimulationLimits& limits;
+    SimulationResult result;
+
+    uint32_t regs[32] = {};
+    uint32_t hi = 0;
+    uint32_t lo = 0;
+    uint32_t heap_end = 0;
+
+    std::unordered_map<uint32_t, std::unique_ptr<uint8_t[]>> pages;
+    uint8_t* last_page = nullptr;
+    uint32_t last_page_number = 0;
+};
+}
+
+namespace cminus
+{
+auto MipsProgram::assemble(std::string_view source, std::string& error)
+        -> std::optional<MipsProgram>
+{
+    Assembler assembler(error);
+    if(!assembler.run(source))
+        return std::nullopt;
+
+    MipsProgram program;
+    program.text = std::move(assembler.text);
+    program.data = std::move(assembler.data);
+    program.entry_index = assembler.entry;
+    return program;
+}
+
+auto simulate(const MipsProgram& program,
+              std::string_view input,
+              const SimulationLimits& limits) -> SimulationResult
+{
+    return Machine(program, input, limits).run();
+}
+}
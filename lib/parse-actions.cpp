@@ -0,0 +1,349 @@
+#include <cminus/parse-actions.hpp>
+#include <cminus/utility/contracts.hpp>
+
+namespace cminus
+{
+auto SemaActions::accept() -> Result
+{
+    assert(values.size() == 1 && open_scopes == 0);
+    return pop_value<Result>();
+}
+
+auto SemaActions::reject() -> Result
+{
+    // Leave any scope left open by the parsing failure.
+    for(; open_scopes > 0; --open_scopes)
+        sema.leave_scope();
+    values.clear();
+    return nullptr;
+}
+
+bool SemaActions::run_action(ParseAction action)
+{
+    using ProgramPtr = std::shared_ptr<ASTProgram>;
+    using VarDeclPtr = std::shared_ptr<ASTVarDecl>;
+    using FunDeclPtr = std::shared_ptr<ASTFunDecl>;
+    using StmtPtr = std::shared_ptr<ASTStmt>;
+    using ExprPtr = std::shared_ptr<ASTExpr>;
+
+    switch(action)
+    {
+        // <program> ::= <declaration-list>
+        case ParseAction::ProgramStart:
+        {
+            values.emplace_back(sema.act_on_program_start());
+            return true;
+        }
+
+        case ParseAction::ProgramEnd:
+        {
+            auto program = pop_value<ProgramPtr>();
+            values.emplace_back(sema.act_on_program_end(std::move(program)));
+            return true;
+        }
+
+        // <declaration> ::= <var-declaration> | <fun-declaration>
+        case ParseAction::TopLevelDecl:
+        {
+            std::shared_ptr<ASTDecl> decl;
+            if(std::holds_alternative<FunDeclPtr>(values.back()))
+                decl = pop_value<FunDeclPtr>();
+            else
+                decl = pop_value<VarDeclPtr>();
+            sema.act_on_top_level_decl(top_value<ProgramPtr>(), std::move(decl));
+            return true;
+        }
+
+        // <var-declaration> ::= <type-specifier> ID ; | <type-specifier> ID [ NUM ] ;
+        //                     | <type-specifier> ID [ NUM ] [ NUM ] ;
+        case ParseAction::VarDecl:
+        case ParseAction::ArrayVarDecl:
+        case ParseAction::MatrixVarDecl:
+        {
+            std::shared_ptr<ASTNumber> num, cols;
+            if(action == ParseAction::MatrixVarDecl)
+                cols = pop_value<ExprPtr>()->as_number_expr();
+            if(action != ParseAction::VarDecl)
+                num = pop_value<ExprPtr>()->as_number_expr();
+
+            auto id = pop_value<Word>();
+            auto type = pop_value<Word>();
+            values.emplace_back(sema.act_on_var_decl(type, id, std::move(num), std::move(cols)));
+            return true;
+        }
+
+        // <fun-declaration> ::= <type-specifier> ID ( <params> ) <compound-stmt>
+        case ParseAction::FunDeclStart:
+        {
+            auto id = pop_value<Word>();
+            auto retn = pop_value<Word>();
+            auto fun_decl = sema.act_on_fun_decl_start(retn, id);
+            assert(fun_decl != nullptr);
+            values.emplace_back(std::move(fun_decl));
+            return true;
+        }
+
+        // <fun-body> ::= [ [ <attribute-list> ] ] <fun-body> | <compound-stmt>
+        case ParseAction::FunAttribute:
+        {
+            auto id = pop_value<Word>();
+            return sema.act_on_fun_attribute(*top_value<FunDeclPtr>(), id);
+        }
+
+        case ParseAction::FunDeclBody:
+        {
+            auto comp_stmt = pop_value<StmtPtr>()->as_compound_stmt();
+            top_value<FunDeclPtr>()->set_body(std::move(comp_stmt));
+            return true;
+        }
+
+        case ParseAction::FunDeclEnd:
+        {
+            auto fun_decl = pop_value<FunDeclPtr>();
+            values.emplace_back(sema.act_on_fun_decl_end(std::move(fun_decl)));
+            return true;
+        }
+
+        // <param> ::= <type-specifier> ID | <type-specifier> ID [ ]
+        case ParseAction::ScalarParam:
+        case ParseAction::ArrayParam:
+        {
+            auto id = pop_value<Word>();
+            auto type = pop_value<Word>();
+            bool is_array = (action == ParseAction::ArrayParam);
+            if(auto param = sema.act_on_param_decl(type, id, is_array))
+            {
+                top_value<FunDeclPtr>()->add_param(std::move(param));
+                return true;
+            }
+            return false;
+        }
+
+        case ParseAction::Discard:
+        {
+            values.pop_back();
+            return true;
+        }
+
+        // Each function has a scope for its parameters which stays active
+        // while its body is parsed. Each compound statement has its own scope.
+        case ParseAction::EnterParamsScope:
+        case ParseAction::EnterFunScope:
+        case ParseAction::EnterScope:
+        {
+            if(action == ParseAction::EnterParamsScope)
+                sema.enter_scope(ScopeFlags::FunParamsScope);
+            else if(action == ParseAction::EnterFunScope)
+                sema.enter_scope(ScopeFlags::CompoundStmt | ScopeFlags::FunScope);
+            else
+                sema.enter_scope(ScopeFlags::CompoundStmt);
+            ++this->open_scopes;
+            return true;
+        }
+
+        case ParseAction::LeaveScope:
+        {
+            assert(open_scopes > 0);
+            sema.leave_scope();
+            --this->open_scopes;
+            return true;
+        }
+
+        // <compound-stmt> ::= { <local-declarations> <statement-list> }
+        case ParseAction::CompoundStart:
+        {
+            values.emplace_back(std::vector<VarDeclPtr>());
+            return true;
+        }
+
+        case ParseAction::AppendDecl:
+        {
+            auto decl = pop_value<VarDeclPtr>();
+            top_value<std::vector<VarDeclPtr>>().push_back(std::move(decl));
+            return true;
+        }
+
+        case ParseAction::StatementsStart:
+        {
+            values.emplace_back(std::vector<StmtPtr>());
+            return true;
+        }
+
+        case ParseAction::AppendStmt:
+        {
+            auto stmt = pop_value<StmtPtr>();
+            top_value<std::vector<StmtPtr>>().push_back(std::move(stmt));
+            return true;
+        }
+
+        case ParseAction::CompoundStmt:
+        {
+            auto stms = pop_value<std::vector<StmtPtr>>();
+            auto decls = pop_value<std::vector<VarDeclPtr>>();
+            values.emplace_back(StmtPtr(sema.act_on_compound_stmt(std::move(decls),
+                                                                  std::move(stms))));
+            return true;
+        }
+
+        // <expression-stmt> ::= <expression> ; | ;
+        case ParseAction::NullStmt:
+        {
+            values.emplace_back(StmtPtr(sema.act_on_null_stmt()));
+            return true;
+        }
+
+        case ParseAction::ExprStmt:
+        {
+            auto expr = pop_value<ExprPtr>();
+            values.emplace_back(StmtPtr(sema.act_on_expr_stmt(std::move(expr))));
+            return true;
+        }
+
+        // <selection-stmt> ::= if ( <expression> ) <statement>
+        //                  | if ( <expression> ) <statement> else <statement>
+        case ParseAction::SelectionStmt:
+        case ParseAction::SelectionElseStmt:
+        {
+            StmtPtr stmt2;
+            if(action == ParseAction::SelectionElseStmt)
+                stmt2 = pop_value<StmtPtr>();
+            auto stmt1 = pop_value<StmtPtr>();
+            auto expr = pop_value<ExprPtr>();
+            values.emplace_back(StmtPtr(sema.act_on_selection_stmt(std::move(expr),
+                                                                   std::move(stmt1),
+                                                                   std::move(stmt2))));
+            return true;
+        }
+
+        // <iteration-stmt> ::= while ( <expression> ) <statement>
+        case ParseAction::IterationStmt:
+        {
+            auto stmt = pop_value<StmtPtr>();
+            auto expr = pop_value<ExprPtr>();
+            values.emplace_back(StmtPtr(sema.act_on_iteration_stmt(std::move(expr),
+                                                                   std::move(stmt))));
+            return true;
+        }
+
+        // <return-stmt> ::= return ; | return <expression> ;
+        case ParseAction::ReturnStmt:
+        case ParseAction::ReturnValueStmt:
+        {
+            ExprPtr expr;
+            if(action == ParseAction::ReturnValueStmt)
+                expr = pop_value<ExprPtr>();
+            auto return_word = pop_value<Word>();
+            values.emplace_back(StmtPtr(sema.act_on_return_stmt(std::move(expr),
+                                                                return_word)));
+            return true;
+        }
+
+        // <expression> ::= <var> <assignop> <expression> | <simple-expression>
+        case ParseAction::CheckAssign:
+        {
+            // The parser checks this one by itself.
+            return true;
+        }
+
+        case ParseAction::Assign:
+        {
+            auto rhs = pop_value<ExprPtr>();
+            auto op_word = pop_value<Word>();
+            auto lvalue = pop_value<ExprPtr>()->as_var_expr();
+            if(op_word.category != Category::Assign)
+            {
+                values.emplace_back(ExprPtr(sema.act_on_compound_assign(std::move(lvalue),
+                                                                        std::move(rhs), op_word)));
+                return true;
+            }
+            values.emplace_back(ExprPtr(sema.act_on_assign(std::move(lvalue),
+                                                           std::move(rhs), op_word)));
+            return true;
+        }
+
+        // <simple-expression>, <additive-expression> and <term>
+        case ParseAction::BinaryExpr:
+        {
+            auto rhs = pop_value<ExprPtr>();
+            auto op_word = pop_value<Word>();
+            auto lhs = pop_value<ExprPtr>();
+            values.emplace_back(ExprPtr(sema.act_on_binary_expr(std::move(lhs),
+                                                                std::move(rhs), op_word)));
+            return true;
+        }
+
+        // NUM
+        case ParseAction::Number:
+        {
+            auto word = pop_value<Word>();
+            values.emplace_back(ExprPtr(sema.act_on_number(word)));
+            return true;
+        }
+
+        // <var> ::= ID | ID [ <expression> ] | ID [ <expression> ] [ <expression> ]
+        case ParseAction::Var:
+        case ParseAction::IndexedVar:
+        case ParseAction::MatrixVar:
+        {
+            ExprPtr index, col_index;
+            if(action == ParseAction::MatrixVar)
+                col_index = pop_value<ExprPtr>();
+            if(action != ParseAction::Var)
+                index = pop_value<ExprPtr>();
+            auto id = pop_value<Word>();
+            if(auto var = sema.act_on_var(id, std::move(index), std::move(col_index)))
+            {
+                values.emplace_back(ExprPtr(std::move(var)));
+                return true;
+            }
+            return false;
+        }
+
+        // <incop> <var> | <var> <incop>
+        case ParseAction::PreIncrement:
+        {
+            auto var = pop_value<ExprPtr>()->as_var_expr();
+            auto op_word = pop_value<Word>();
+            values.emplace_back(ExprPtr(sema.act_on_increment(std::move(var), op_word, false)));
+            return true;
+        }
+
+        case ParseAction::PostIncrement:
+        {
+            auto op_word = pop_value<Word>();
+            auto var = pop_value<ExprPtr>()->as_var_expr();
+            values.emplace_back(ExprPtr(sema.act_on_increment(std::move(var), op_word, true)));
+            return true;
+        }
+
+        // <call> ::= ID ( <args> )
+        case ParseAction::CallStart:
+        {
+            values.emplace_back(std::vector<ExprPtr>());
+            return true;
+        }
+
+        case ParseAction::AppendArg:
+        {
+            auto expr = pop_value<ExprPtr>();
+            top_value<std::vector<ExprPtr>>().push_back(std::move(expr));
+            return true;
+        }
+
+        case ParseAction::Call:
+        {
+            auto rparen = pop_value<Word>();
+            auto args = pop_value<std::vector<ExprPtr>>();
+            auto id = pop_value<Word>();
+            if(auto call = sema.act_on_call(id, std::move(args), rparen.location()))
+            {
+                values.emplace_back(ExprPtr(std::move(call)));
+                return true;
+            }
+            return false;
+        }
+    }
+
+    cminus_unreachable();
+}
+}
@@ -0,0 +1,97 @@
+#include <cminus/perf-counters.hpp>
+#include <cminus/utility/contracts.hpp>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cminus
+{
+PerfCounters::PerfCounters()
+{
+    for(auto& fd : fds)
+        fd = -1;
+
+#ifdef __linux__
+    static constexpr uint64_t configs[NumEvents] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_MISSES,
+    };
+
+    for(size_t i = 0; i < NumEvents; ++i)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        this->fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for(auto fd : fds)
+    {
+        if(fd != -1)
+            close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::available() const
+{
+    for(auto fd : fds)
+    {
+        if(fd != -1)
+            return true;
+    }
+    return false;
+}
+
+auto PerfCounters::read() const -> Sample
+{
+    Sample sample;
+#ifdef __linux__
+    for(size_t i = 0; i < NumEvents; ++i)
+    {
+        // The value, then the time enabled and the time running.
+        uint64_t data[3];
+        if(fds[i] == -1 || ::read(fds[i], data, sizeof(data)) != sizeof(data))
+            continue;
+
+        if(data[2] != 0 && data[2] < data[1])
+            data[0] = static_cast<uint64_t>(double(data[0]) * data[1] / data[2]);
+        sample.values[i] = data[0];
+    }
+#endif
+    return sample;
+}
+
+auto PerfCounters::event_name(Event event) -> const char*
+{
+    switch(event)
+    {
+        case Cycles:
+            return "cycles";
+        case Instructions:
+            return "instructions";
+        case BranchMisses:
+            return "branch-misses";
+        case CacheMisses:
+            return "cache-misses";
+        default:
+            cminus_unreachable();
+    }
+}
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cminus/ast-visitor.hpp>
+#include <cminus/row-hoisting.hpp>
+#include <unordered_set>
+
+namespace
+{
+using namespace cminus;
+
+/// Collects the element accesses of two-dimensional arrays made by a loop,
+/// along with the scalars it assigns and the calls it makes.
+class LoopRowCollector : public ASTVisitor
+{
+public:
+    void visit_var_expr(ASTVarRef& var_ref) override
+    {
+        if(var_ref.get_col_index())
+            this->accesses.push_back(&var_ref);
+        walk_var_expr(var_ref);
+    }
+
+    void visit_call_expr(ASTFunCall& call) override
+    {
+        this->calls.push_back(&call);
+        walk_call_expr(call);
+    }
+
+    void visit_binary_expr(ASTBinaryExpr& expr) override
+    {
+        if(expr.get_operation() != ASTBinaryExpr::Operation::Assign)
+        {
+            walk_binary_expr(expr);
+            return;
+        }
+
+        auto var_ref = expr.get_left()->as_var_expr();
+        if(!var_ref->get_index())
+            this->assigned.insert(var_ref->get_decl().get());
+        visit_var_expr(*var_ref);
+        visit_expr(*expr.get_right());
+    }
+
+    void visit_compound_assign_expr(ASTCompoundAssignExpr& expr) override
+    {
+        auto var_ref = expr.get_var();
+        if(!var_ref->get_index())
+            this->assigned.insert(var_ref->get_decl().get());
+        walk_compound_assign_expr(expr);
+    }
+
+public:
+    std::vector<ASTVarRef*> accesses;
+    std::unordered_set<const ASTVarDecl*> assigned;
+    std::vector<ASTFunCall*> calls;
+};
+
+/// Hoists rows out of the loops of a function, outermost loops first.
+class LoopRowHoister : public ASTVisitor
+{
+public:
+    explicit LoopRowHoister(
+            const AliasAnalysis& aliases,
+            std::unordered_map<const ASTIterationStmt*, std::vector<HoistedRow>>& hoisted,
+            std::unordered_map<const ASTVarRef*, int>& row_of) :
+        aliases(aliases),
+        hoisted(hoisted),
+        row_of(row_of)
+    {
+    }
+
+    void visit_iteration_stmt(ASTIterationStmt& loop) override
+    {
+        LoopRowCollector collector;
+        collector.walk_iteration_stmt(loop);
+
+        auto& loop_rows = this->hoisted[&loop];
+        for(auto access : collector.accesses)
+        {
+            if(row_of.count(access) || !is_invariant(*access->get_index(), collector))
+                continue;
+
+            auto it = std::find_if(loop_rows.begin(), loop_rows.end(), [&](const HoistedRow& row) {
+                return row.array == access->get_decl().get()
+                       && same_index(*row.index, *access->get_index());
+            });
+            if(it == loop_rows.end())
+            {
+                const auto row = HoistedRow{access->get_decl().get(),
+                                            access->get_index().get(),
+                                            num_rows++};
+                it = loop_rows.insert(it, row);
+            }
+            this->row_of.emplace(access, it->id);
+        }
+
+        walk_iteration_stmt(loop);
+    }
+
+private:
+    /// \returns whether a row subscript has the same value throughout the
+    /// loop the collector went through.
+    bool is_invariant(ASTExpr& index, const LoopRowCollector& collector) const
+    {
+        if(index.as_number_expr())
+            return true;
+
+        auto var_ref = index.as_var_expr();
+        if(!var_ref || var_ref->type() != ExprType::Int || var_ref->get_index())
+            return false;
+
+        auto var = var_ref->get_decl().get();
+        if(collector.assigned.count(var))
+            return false;
+
+        return std::none_of(collector.calls.begin(), collector.calls.end(), [&](ASTFunCall* call) {
+            return !!(aliases.get_mod_ref(*call, *var) & ModRef::Mod);
+        });
+    }
+
+    /// \returns whether two invariant row subscripts have the same value.
+    static bool same_index(ASTExpr& lhs, ASTExpr& rhs)
+    {
+        auto lhs_number = lhs.as_number_expr();
+        auto rhs_number = rhs.as_number_expr();
+        if(lhs_number || rhs_number)
+            return lhs_number && rhs_number && lhs_number->get_value() == rhs_number->get_value();
+        return lhs.as_var_expr()->get_decl() == rhs.as_var_expr()->get_decl();
+    }
+
+private:
+    const AliasAnalysis& aliases;
+    std::unordered_map<const ASTIterationStmt*, std::vector<HoistedRow>>& hoisted;
+    std::unordered_map<const ASTVarRef*, int>& row_of;
+    int num_rows = 0;
+};
+}
+
+namespace cminus
+{
+RowHoisting::RowHoisting(ASTFunDecl& fun, const AliasAnalysis& aliases)
+{
+    LoopRowHoister hoister(aliases, this->hoisted, this->row_of);
+    hoister.visit_compound_stmt(*fun.get_body());
+}
+
+auto RowHoisting::get_hoisted(const ASTIterationStmt& loop) const
+        -> const std::vector<HoistedRow>&
+{
+    auto it = hoisted.find(&loop);
+    if(it == hoisted.end())
+        return none;
+    return it->second;
+}
+
+int RowHoisting::get_row_id(const ASTVarRef& var_ref) const
+{
+    auto it = row_of.find(&var_ref);
+    return it != row_of.end() ? it->second : -1;
+}
+}
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <cminus/scalar-replacement.hpp>
+#include <cminus/utility/contracts.hpp>
+#include <iterator>
+#include <optional>
+
+namespace
+{
+using namespace cminus;
+
+/// Registers elements may be kept in.
+constexpr uint8_t element_regs[] = {9, 10, 11, 12, 13, 14, 15, 24, 25};
+constexpr size_t max_keys = std::size(element_regs);
+
+/// Identifies an array element by the array and the subscript.
+struct ElementKey
+{
+    ASTVarDecl* array;
+    ASTVarDecl* index_var; //< null if the subscript is a number
+    int32_t index_value;
+
+    bool operator==(const ElementKey& rhs) const
+    {
+        return array == rhs.array && index_var == rhs.index_var
+               && (index_var != nullptr || index_value == rhs.index_value);
+    }
+};
+
+/// A set of keys, by their index in `ScalarReplacementSolver::keys`.
+using KeySet = uint32_t;
+static_assert(max_keys <= 32, "KeySet is too small");
+
+/// Walks through an expression reporting, in the order the generated code
+/// evaluates it, the events that matter to scalar replacement.
+///
+/// The handler receives `on_load(ASTVarRef&)` for reads of an element,
+/// `on_store(ASTAssignExpr&)` for writes into an element, `on_update(
+/// ASTVarRef&)` for reads and writes into an element by a compound
+/// assignment, `on_assign_var(ASTVarDecl&)` for writes into a scalar
+/// variable and `on_call(ASTFunCall&)`.
+template<typename Handler>
+void walk_events(ASTExpr& expr, Handler& handler)
+{
+    switch(expr.expr_kind())
+    {
+        case ExprKind::Number:
+            break;
+        case ExprKind::VarRef:
+        {
+            auto& var_ref = static_cast<ASTVarRef&>(expr);
+            if(auto index = var_ref.get_index())
+                walk_events(*index, handler);
+            if(auto col_index = var_ref.get_col_index())
+                walk_events(*col_index, handler);
+
+            // Naming a row of a two-dimensional array does not load it.
+            if(var_ref.get_index() && var_ref.type() != ExprType::Array)
+                handler.on_load(var_ref);
+            break;
+        }
+        case ExprKind::FunCall:
+        {
+            auto& call = static_cast<ASTFunCall&>(expr);
+            for(auto it = call.arg_begin(); it != call.arg_end(); ++it)
+                walk_events(**it, handler);
+            handler.on_call(call);
+            break;
+        }
+        case ExprKind::BinaryExpr:
+        {
+            auto& binary = static_cast<ASTBinaryExpr&>(expr);
+            walk_events(*binary.get_left(), handler);
+            walk_events(*binary.get_right(), handler);
+            break;
+        }
+        case ExprKind::AssignExpr:
+        {
+            auto& assign = static_cast<ASTAssignExpr&>(expr);
+            auto& var_ref = static_cast<ASTVarRef&>(*assign.get_left());
+            if(auto index = var_ref.get_index())
+            {
+                // The address is computed before the value.
+                walk_events(*index, handler);
+                if(auto col_index = var_ref.get_col_index())
+                    walk_events(*col_index, handler);
+                walk_events(*assign.get_right(), handler);
+                handler.on_store(assign);
+            }
+            else
+            {
+                walk_events(*assign.get_right(), handler);
+                handler.on_assign_var(*var_ref.get_decl());
+            }
+            break;
+        }
+        case ExprKind::CompoundAssignExpr:
+        {
+            auto& assign = static_cast<ASTCompoundAssignExpr&>(expr);
+            auto& var_ref = *assign.get_var();
+            if(auto index = var_ref.get_index())
+            {
+                walk_events(*index, handler);
+                if(auto col_index = var_ref.get_col_index())
+                    walk_events(*col_index, handler);
+                walk_events(*assign.get_right(), handler);
+                handler.on_update(var_ref);
+            }
+            else
+            {
+                walk_events(*assign.get_right(), handler);
+                handler.on_assign_var(*var_ref.get_decl());
+            }
+            break;
+        }
+        default:
+            cminus_unreachable();
+    }
+}
+
+/// \returns whether evaluating an expression may modify a scalar variable.
+bool may_modify(ASTExpr& expr, const ASTVarDecl& var, const AliasAnalysis& aliases)
+{
+    struct Handler
+    {
+        const ASTVarDecl& var;
+        const AliasAnalysis& aliases;
+        bool result = false;
+
+        void on_load(ASTVarRef&) {}
+        void on_store(ASTAssignExpr&) {}
+        void on_update(ASTVarRef&) {}
+        void on_assign_var(ASTVarDecl& decl) { result |= (&decl == &var); }
+        void on_call(ASTFunCall& call)
+        {
+            result |= !!(aliases.get_mod_ref(call, var) & ModRef::Mod);
+        }
+    } handler{var, aliases};
+
+    walk_events(expr, handler);
+    return handler.result;
+}
+
+class ScalarReplacementSolver
+{
+public:
+    explicit ScalarReplacementSolver(const CFG& cfg, const AliasAnalysis& aliases) :
+        cfg(cfg),
+        aliases(aliases)
+    {
+    }
+
+    /// Chooses which elements are kept in registers.
+    void assign_keys()
+    {
+        struct Candidate
+        {
+            ElementKey key;
+            size_t uses;
+        };
+
+        struct Handler
+        {
+            ScalarReplacementSolver& solver;
+            std::vector<Candidate> candidates;
+            std::unordered_map<const ASTExpr*, size_t> candidate_of;
+
+            void on_load(ASTVarRef& var_ref)
+            {
+                if(auto key = solver.key_of(var_ref, nullptr))
+                    add_access(var_ref, *key);
+            }
+
+            void on_store(ASTAssignExpr& assign)
+            {
+                auto& var_ref = static_cast<ASTVarRef&>(*assign.get_left());
+                if(auto key = solver.key_of(var_ref, assign.get_right().get()))
+                    add_access(assign, *key);
+            }
+
+            void on_update(ASTVarRef&) {}
+            void on_assign_var(ASTVarDecl&) {}
+            void on_call(ASTFunCall&) {}
+
+            void add_access(const ASTExpr& expr, ElementKey key)
+            {
+                auto it = std::find_if(candidates.begin(), candidates.end(),
+                                       [&](const Candidate& c) { return c.key == key; });
+                if(it == candidates.end())
+                    it = candidates.insert(it, Candidate{key, 0});
+                ++it->uses;
+                candidate_of.emplace(&expr, it - candidates.begin());
+            }
+        } handler{*this, {}, {}};
+
+        for(const auto& block : cfg)
+        {
+            for(auto expr : block.exprs)
+                walk_events(*expr, handler);
+            if(block.cond)
+                walk_events(*block.cond, handler);
+        }
+
+        const auto& candidates = handler.candidates;
+
+        // Elements accessed only once have nothing to gain.
+        std::vector<size_t> order;
+        for(size_t i = 0; i < candidates.size(); ++i)
+        {
+            if(candidates[i].uses > 1)
+                order.push_back(i);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return candidates[a].uses > candidates[b].uses;
+        });
+
+        if(order.size() > max_keys)
+            order.resize(max_keys);
+
+        std::vector<int> key_of_candidate(candidates.size(), -1);
+        for(auto i : order)
+        {
+            key_of_candidate[i] = static_cast<int>(keys.size());
+            this->keys.push_back(candidates[i].key);
+        }
+
+        for(const auto& [expr, candidate] : handler.candidate_of)
+        {
+            if(key_of_candidate[candidate] != -1)
+                this->key_of_access.emplace(expr, key_of_candidate[candidate]);
+        }
+    }
+
+    /// Finds the elements available in registers at the beginning of each
+    /// block, which are those kept in every path reaching it.
+    void solve()
+    {
+        const KeySet all_keys = (keys.size() == 32 ? ~KeySet(0)
+                                                   : (KeySet(1) << keys.size()) - 1);
+
+        this->block_in.assign(cfg.size(), all_keys);
+        this->block_in[cfg.entry()] = 0;
+
+        std::vector<KeySet> block_out(cfg.size(), all_keys);
+
+        bool changed = true;
+        while(changed)
+        {
+            changed = false;
+            for(CFGBlockId id = 0; id < cfg.size(); ++id)
+            {
+                const auto& block = cfg.block(id);
+
+                KeySet in = (id == cfg.entry() || block.preds.empty() ? 0 : all_keys);
+                for(auto pred : block.preds)
+                    in &= block_out[pred];
+
+                EventHandler handler{*this, in, nullptr};
+                for(auto expr : block.exprs)
+                    walk_events(*expr, handler);
+                if(block.cond)
+                    walk_events(*block.cond, handler);
+
+                if(in != block_in[id] || handler.available != block_out[id])
+                {
+                    this->block_in[id] = in;
+                    block_out[id] = handler.available;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    /// Decides how each access to a kept element is performed.
+    void replay(std::unordered_map<const ASTExpr*, ElementAccess>& accesses)
+    {
+        for(CFGBlockId id = 0; id < cfg.size(); ++id)
+        {
+            const auto& block = cfg.block(id);
+
+            EventHandler handler{*this, block_in[id], &accesses};
+            for(auto expr : block.exprs)
+                walk_events(*expr, handler);
+            if(block.cond)
+                walk_events(*block.cond, handler);
+        }
+    }
+
+private:
+    /// Tracks the elements available in registers through a block.
+    struct EventHandler
+    {
+        ScalarReplacementSolver& solver;
+        KeySet available;
+
+        /// Where to record the decisions, if anywhere.
+        std::unordered_map<const ASTExpr*, ElementAccess>* accesses;
+
+        /// The last store into each key, if not yet followed by anything
+        /// that could observe the memory it writes.
+        std::vector<const ASTExpr*> pending_stores = std::vector<const ASTExpr*>(max_keys);
+
+        void on_load(ASTVarRef& var_ref)
+        {
+            const auto key = solver.find_key(var_ref);
+            if(key != -1 && (available & (KeySet(1) << key)))
+            {
+                record(var_ref, ElementAccess::Reuse, key);
+                return;
+            }
+
+            if(key != -1)
+            {
+                record(var_ref, ElementAccess::Keep, key);
+                this->available |= (KeySet(1) << key);
+            }
+
+            // Memory is going to be read, so pending stores that may write
+            // into the same place must really happen.
+            flush_stores(solver.aliasing_keys(var_ref.get_decl().get()));
+        }
+
+        void on_store(ASTAssignExpr& assign)
+        {
+            auto& var_ref = static_cast<ASTVarRef&>(*assign.get_left());
+            this->available &= ~solver.aliasing_keys(var_ref.get_decl().get());
+
+            const auto key = solver.find_key(assign);
+            if(key != -1)
+            {
+                if(auto prev_store = pending_stores[key])
+                    record(*prev_store, ElementAccess::Defer, key);
+
+                record(assign, ElementAccess::Keep, key);
+                this->available |= (KeySet(1) << key);
+                this->pending_stores[key] = &assign;
+            }
+        }
+
+        void on_update(ASTVarRef& var_ref)
+        {
+            // The element is updated in memory, which pending stores to the
+            // same place must reach first.
+            const auto keys = solver.aliasing_keys(var_ref.get_decl().get());
+            this->available &= ~keys;
+            flush_stores(keys);
+        }
+
+        void on_assign_var(ASTVarDecl& decl)
+        {
+            const auto keys = solver.keys_indexed_by(decl);
+            this->available &= ~keys;
+            flush_stores(keys);
+        }
+
+        void on_call(ASTFunCall&)
+        {
+            // The registers do not survive the call. Pending stores must
+            // happen as well, even if the callee cannot observe them, since
+            // it may print before a store would go out of bounds.
+            this->available = 0;
+            flush_stores(~KeySet(0));
+        }
+
+        void flush_stores(KeySet keys)
+        {
+            for(size_t i = 0; i < max_keys; ++i)
+            {
+                if(keys & (KeySet(1) << i))
+                    this->pending_stores[i] = nullptr;
+            }
+        }
+
+        void record(const ASTExpr& expr, ElementAccess::Kind kind, int key)
+        {
+            if(accesses)
+                (*accesses)[&expr] = ElementAccess{kind, element_regs[key]};
+        }
+    };
+
+    /// \returns the key of a kept element accessed by an expression, or -1.
+    int find_key(const ASTExpr& expr) const
+    {
+        auto it = key_of_access.find(&expr);
+        return it != key_of_access.end() ? it->second : -1;
+    }
+
+    /// \returns the key of the element accessed by a subscripted variable
+    /// reference if it can be kept, or nothing.
+    ///
+    /// For stores, `value` is the stored expression, which must not change
+    /// the subscript after the address of the element is computed.
+    auto key_of(ASTVarRef& var_ref, ASTExpr* value) const -> std::optional<ElementKey>
+    {
+        auto array = var_ref.get_decl().get();
+        auto index = var_ref.get_index();
+        assert(index != nullptr);
+
+        // Elements of two-dimensional arrays are not kept, though accesses
+        // to them still invalidate the kept elements of aliasing arrays.
+        if(var_ref.get_col_index())
+            return std::nullopt;
+
+        if(auto number = index->as_number_expr())
+            return ElementKey{array, nullptr, number->get_value()};
+
+        if(auto index_ref = index->as_var_expr())
+        {
+            auto index_var = index_ref->get_decl().get();
+            if(index_var->is_array() || index_ref->get_index())
+                return std::nullopt;
+
+            if(value && may_modify(*value, *index_var, aliases))
+                return std::nullopt;
+
+            return ElementKey{array, index_var, 0};
+        }
+
+        return std::nullopt;
+    }
+
+    /// \returns the kept elements of arrays that may share memory with the
+    /// array `decl`.
+    auto aliasing_keys(ASTVarDecl* decl) const -> KeySet
+    {
+        KeySet result = 0;
+        for(size_t i = 0; i < keys.size(); ++i)
+        {
+            if(aliases.may_alias(*keys[i].array, *decl))
+                result |= (KeySet(1) << i);
+        }
+        return result;
+    }
+
+    /// \returns the kept elements whose subscript is the variable `decl`.
+    auto keys_indexed_by(const ASTVarDecl& decl) const -> KeySet
+    {
+        KeySet result = 0;
+        for(size_t i = 0; i < keys.size(); ++i)
+        {
+            if(keys[i].index_var == &decl)
+                result |= (KeySet(1) << i);
+        }
+        return result;
+    }
+
+private:
+    const CFG& cfg;
+    const AliasAnalysis& aliases;
+
+    /// The kept elements, their index is their key.
+    std::vector<ElementKey> keys;
+    std::unordered_map<const ASTExpr*, int> key_of_access;
+
+    std::vector<KeySet> block_in;
+};
+}
+
+namespace cminus
+{
+ScalarReplacement::ScalarReplacement(const CFG& cfg, const AliasAnalysis& aliases)
+{
+    ScalarReplacementSolver solver(cfg, aliases);
+    solver.assign_keys();
+    solver.solve();
+    solver.replay(this->accesses);
+}
+
+auto ScalarReplacement::get_access(const ASTExpr& expr) const -> ElementAccess
+{
+    auto it = accesses.find(&expr);
+    if(it == accesses.end())
+        return ElementAccess{};
+    return it->second;
+}
+}
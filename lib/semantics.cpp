@@ -1,4 +1,5 @@
 #include <cminus/semantics.hpp>
+#include <stdexcept>
 
 namespace cminus
 {
@@ -44,6 +45,9 @@ void Semantics::enter_scope(ScopeFlags flags)
     auto old_scope = std::move(current_scope);
     auto new_scope = std::make_unique<Scope>(flags, std::move(old_scope));
     current_scope = std::move(new_scope);
+
+    if(stats)
+        ++this->stats->scopes;
 }
 
 void Semantics::leave_scope()
@@ -52,6 +56,21 @@ void Semantics::leave_scope()
     assert(current_scope != nullptr);
 }
 
+auto Semantics::lookup(SourceRange name) -> std::shared_ptr<ASTDecl>
+{
+    if(!stats)
+        return current_scope->lookup(name);
+
+    ++this->stats->lookups;
+    for(const Scope* scope = current_scope.get(); scope != nullptr; scope = scope->get_parent())
+    {
+        if(auto decl = scope->lookup_exclusive(name))
+            return decl;
+        ++this->stats->lookup_misses;
+    }
+    return nullptr;
+}
+
 auto Semantics::get_scope() -> Scope&
 {
     assert(current_scope != nullptr);
@@ -61,30 +80,28 @@ auto Semantics::get_scope() -> Scope&
 Semantics::Semantics(SourceFile& source_a,
                      DiagnosticManager& diagman_a) :
     source(source_a),
-    diagman(diagman_a)
+    diagman(diagman_a),
+    source_table(std::make_shared<ASTSourceTable>())
 {
     current_scope = std::make_unique<Scope>(ScopeFlags::TopLevel, nullptr);
 
-    fun_println = make_builtin(Category::Void, "println", {"value"});
-    fun_input = make_builtin(Category::Int, "input", {});
+    fun_println = make_builtin(ExprType::Void, "println", {"value"});
+    fun_input = make_builtin(ExprType::Int, "input", {});
+    fun_alloc = make_builtin(ExprType::Array, "alloc", {"size"});
 }
 
-auto Semantics::make_builtin(Category retn_type,
+auto Semantics::make_builtin(ExprType retn_type,
                              std::string name_a,
                              std::vector<std::string> params)
         -> std::shared_ptr<ASTFunDecl>
 {
-    assert(retn_type == Category::Void
-           || retn_type == Category::Int);
-
-    auto is_void = (retn_type == Category::Void);
     auto name = source.make_source_range(std::move(name_a));
-    auto fun_decl = std::make_shared<ASTFunDecl>(is_void, name);
+    auto fun_decl = make_node<ASTFunDecl>(retn_type, name);
 
     for(auto&& parm_name_owned : params)
     {
         auto parm_name = source.make_source_range(std::move(parm_name_owned));
-        fun_decl->add_param(std::make_shared<ASTParmVarDecl>(parm_name, false));
+        fun_decl->add_param(make_node<ASTParmVarDecl>(parm_name, false));
     }
 
     auto [decl, inserted] = current_scope->insert(name, fun_decl);
@@ -95,7 +112,8 @@ auto Semantics::make_builtin(Category retn_type,
 
 auto Semantics::act_on_program_start() -> std::shared_ptr<ASTProgram>
 {
-    return std::make_shared<ASTProgram>();
+    this->source_table = std::make_shared<ASTSourceTable>();
+    return make_node<ASTProgram>(source_table);
 }
 
 auto Semantics::act_on_program_end(std::shared_ptr<ASTProgram> program)
@@ -129,13 +147,17 @@ void Semantics::act_on_top_level_decl(
 }
 
 auto Semantics::act_on_var_decl(const Word& type, const Word& name,
-                                std::shared_ptr<ASTNumber> array_size)
+                                std::shared_ptr<ASTNumber> array_size,
+                                std::shared_ptr<ASTNumber> array_cols)
         -> std::shared_ptr<ASTVarDecl>
 {
     assert(type.category == Category::Void || type.category == Category::Int);
     assert(name.category == Category::Identifier);
+    assert(!array_cols || array_size);
 
-    auto new_decl = std::make_shared<ASTVarDecl>(name.lexeme, std::move(array_size));
+    auto new_decl = (array_cols ? make_node<ASTVarDecl>(name.lexeme, std::move(array_size),
+                                                        std::move(array_cols))
+                                : make_node<ASTVarDecl>(name.lexeme, std::move(array_size)));
 
     auto [decl, inserted] = current_scope->insert(name.lexeme, new_decl);
     if(!inserted)
@@ -151,6 +173,13 @@ auto Semantics::act_on_var_decl(const Word& type, const Word& name,
                 .range(type.lexeme);
     }
 
+    if(new_decl->get_row_bytes() > ASTVarDecl::max_bytes
+       || new_decl->get_num_bytes() > ASTVarDecl::max_bytes)
+    {
+        diagman.report(source, name.location(), Diag::sema_array_too_large)
+                .range(name.lexeme);
+    }
+
     return new_decl;
 }
 
@@ -163,7 +192,7 @@ auto Semantics::act_on_fun_decl_start(const Word& retn_type, const Word& name)
 
     auto is_void = (retn_type.category == Category::Void);
 
-    auto new_decl = std::make_shared<ASTFunDecl>(is_void, name.lexeme);
+    auto new_decl = make_node<ASTFunDecl>(is_void, name.lexeme);
 
     auto [decl, inserted] = current_scope->insert(name.lexeme, new_decl);
     if(!inserted)
@@ -184,6 +213,31 @@ auto Semantics::act_on_fun_decl_end(std::shared_ptr<ASTFunDecl> decl)
     return decl;
 }
 
+bool Semantics::act_on_fun_attribute(ASTFunDecl& decl, const Word& name)
+{
+    assert(name.category == Category::Identifier);
+
+    const auto attr = find_fun_attribute(name.lexeme);
+    if(!attr)
+    {
+        diagman.report(source, name.location(),
+                       Diag::sema_unknown_attribute, name.lexeme)
+                .range(name.lexeme);
+        return false;
+    }
+
+    if(are_conflicting(decl.get_attributes() | attr))
+    {
+        diagman.report(source, name.location(),
+                       Diag::sema_conflicting_attributes, name.lexeme)
+                .range(name.lexeme);
+        return false;
+    }
+
+    decl.add_attributes(attr);
+    return true;
+}
+
 auto Semantics::act_on_param_decl(const Word& type, const Word& name,
                                   bool is_array)
         -> std::shared_ptr<ASTParmVarDecl>
@@ -191,7 +245,7 @@ auto Semantics::act_on_param_decl(const Word& type, const Word& name,
     assert(type.category == Category::Void || type.category == Category::Int);
     assert(name.category == Category::Identifier);
 
-    auto new_decl = std::make_shared<ASTParmVarDecl>(name.lexeme, is_array);
+    auto new_decl = make_node<ASTParmVarDecl>(name.lexeme, is_array);
 
     auto [decl, inserted] = current_scope->insert(name.lexeme, new_decl);
     if(!inserted)
@@ -218,10 +272,46 @@ auto Semantics::act_on_assign(std::shared_ptr<ASTVarRef> lhs,
     if(lhs->type() != ExprType::Int || rhs->type() != ExprType::Int)
     {
         diagman.report(source, op.location(), Diag::sema_assignment_type_error)
-                .range(lhs->source_range())
-                .range(rhs->source_range());
+                .range(source_table->source_range(*lhs))
+                .range(source_table->source_range(*rhs));
     }
-    return std::make_shared<ASTAssignExpr>(std::move(lhs), std::move(rhs));
+    auto id = source_table->add(join_ranges(*lhs, *rhs));
+    return make_node<ASTAssignExpr>(std::move(lhs), std::move(rhs), id);
+}
+
+auto Semantics::act_on_compound_assign(std::shared_ptr<ASTVarRef> lhs,
+                                       std::shared_ptr<ASTExpr> rhs,
+                                       const Word& op)
+        -> std::shared_ptr<ASTCompoundAssignExpr>
+{
+    using Form = ASTCompoundAssignExpr::Form;
+    if(lhs->type() != ExprType::Int || rhs->type() != ExprType::Int)
+    {
+        diagman.report(source, op.location(), Diag::sema_assignment_type_error)
+                .range(source_table->source_range(*lhs))
+                .range(source_table->source_range(*rhs));
+    }
+    auto type = ASTCompoundAssignExpr::type_from_category(op.category);
+    auto id = source_table->add(join_ranges(*lhs, *rhs));
+    return make_node<ASTCompoundAssignExpr>(std::move(lhs), std::move(rhs),
+                                            type, Form::Compound, id);
+}
+
+auto Semantics::act_on_increment(std::shared_ptr<ASTVarRef> var,
+                                 const Word& op, bool is_postfix)
+        -> std::shared_ptr<ASTCompoundAssignExpr>
+{
+    using Form = ASTCompoundAssignExpr::Form;
+    if(var->type() != ExprType::Int)
+    {
+        diagman.report(source, op.location(), Diag::sema_assignment_type_error)
+                .range(source_table->source_range(*var));
+    }
+    auto type = ASTCompoundAssignExpr::type_from_category(op.category);
+    auto one = make_node<ASTNumber>(1, source_table->add(op.lexeme));
+    auto id = source_table->add(is_postfix ? join_ranges(*var, *one) : join_ranges(*one, *var));
+    return make_node<ASTCompoundAssignExpr>(std::move(var), std::move(one), type,
+                                            is_postfix ? Form::Postfix : Form::Prefix, id);
 }
 
 auto Semantics::act_on_binary_expr(std::shared_ptr<ASTExpr> lhs,
@@ -232,17 +322,18 @@ auto Semantics::act_on_binary_expr(std::shared_ptr<ASTExpr> lhs,
     if(lhs->type() != ExprType::Int || rhs->type() != ExprType::Int)
     {
         diagman.report(source, op.location(), Diag::sema_binary_expr_type_error)
-                .range(lhs->source_range())
-                .range(rhs->source_range());
+                .range(source_table->source_range(*lhs))
+                .range(source_table->source_range(*rhs));
     }
     auto type = ASTBinaryExpr::type_from_category(op.category);
-    return std::make_shared<ASTBinaryExpr>(std::move(lhs), std::move(rhs), type);
+    auto id = source_table->add(join_ranges(*lhs, *rhs));
+    return make_node<ASTBinaryExpr>(std::move(lhs), std::move(rhs), type, id);
 }
 
 auto Semantics::act_on_null_stmt()
         -> std::shared_ptr<ASTNullStmt>
 {
-    return std::make_shared<ASTNullStmt>();
+    return make_node<ASTNullStmt>();
 }
 
 auto Semantics::act_on_expr_stmt(std::shared_ptr<ASTExpr> expr)
@@ -250,8 +341,9 @@ auto Semantics::act_on_expr_stmt(std::shared_ptr<ASTExpr> expr)
 {
     if(expr->type() == ExprType::Array)
     {
-        diagman.report(source, expr->location(), Diag::sema_array_statement)
-                .range(expr->source_range());
+        diagman.report(source, source_table->location(*expr),
+                       Diag::sema_array_statement)
+                .range(source_table->source_range(*expr));
     }
     return expr;
 }
@@ -260,7 +352,7 @@ auto Semantics::act_on_compound_stmt(std::vector<std::shared_ptr<ASTVarDecl>> de
                                      std::vector<std::shared_ptr<ASTStmt>> stms)
         -> std::shared_ptr<ASTCompoundStmt>
 {
-    return std::make_shared<ASTCompoundStmt>(std::move(decls), std::move(stms));
+    return make_node<ASTCompoundStmt>(std::move(decls), std::move(stms));
 }
 
 auto Semantics::act_on_selection_stmt(std::shared_ptr<ASTExpr> expr,
@@ -270,10 +362,11 @@ auto Semantics::act_on_selection_stmt(std::shared_ptr<ASTExpr> expr,
 {
     if(expr->type() != ExprType::Int)
     {
-        diagman.report(source, expr->location(), Diag::sema_expr_not_boolean)
-                .range(expr->source_range());
+        diagman.report(source, source_table->location(*expr),
+                       Diag::sema_expr_not_boolean)
+                .range(source_table->source_range(*expr));
     }
-    return std::make_shared<ASTSelectionStmt>(std::move(expr),
+    return make_node<ASTSelectionStmt>(std::move(expr),
                                               std::move(stmt1),
                                               std::move(stmt2));
 }
@@ -284,10 +377,11 @@ auto Semantics::act_on_iteration_stmt(std::shared_ptr<ASTExpr> expr,
 {
     if(expr->type() != ExprType::Int)
     {
-        diagman.report(source, expr->location(), Diag::sema_expr_not_boolean)
-                .range(expr->source_range());
+        diagman.report(source, source_table->location(*expr),
+                       Diag::sema_expr_not_boolean)
+                .range(source_table->source_range(*expr));
     }
-    return std::make_shared<ASTIterationStmt>(std::move(expr), std::move(stmt));
+    return make_node<ASTIterationStmt>(std::move(expr), std::move(stmt));
 }
 
 auto Semantics::act_on_return_stmt(std::shared_ptr<ASTExpr> expr,
@@ -300,12 +394,13 @@ auto Semantics::act_on_return_stmt(std::shared_ptr<ASTExpr> expr,
         {
             diagman.report(source, return_word.location(),
                            Diag::sema_void_fun_returning_value)
-                    .range(expr->source_range());
+                    .range(source_table->source_range(*expr));
         }
         else if(expr->type() != ExprType::Int)
         {
-            diagman.report(source, expr->location(), Diag::sema_incompatible_return_type)
-                    .range(expr->source_range());
+            diagman.report(source, source_table->location(*expr),
+                           Diag::sema_incompatible_return_type)
+                    .range(source_table->source_range(*expr));
         }
     }
     else if(!this->is_current_fun_void)
@@ -313,7 +408,7 @@ auto Semantics::act_on_return_stmt(std::shared_ptr<ASTExpr> expr,
         diagman.report(source, return_word.location(),
                        Diag::sema_int_fun_not_returning_value);
     }
-    return std::make_shared<ASTReturnStmt>(std::move(expr));
+    return make_node<ASTReturnStmt>(std::move(expr));
 }
 
 auto Semantics::act_on_number(const Word& word)
@@ -321,15 +416,18 @@ auto Semantics::act_on_number(const Word& word)
 {
     assert(word.category == Category::Number);
     auto number = number_from_word(word);
-    return std::make_shared<ASTNumber>(number, word.lexeme);
+    return make_node<ASTNumber>(number, source_table->add(word.lexeme));
 }
 
-auto Semantics::act_on_var(const Word& name, std::shared_ptr<ASTExpr> index)
+auto Semantics::act_on_var(const Word& name, std::shared_ptr<ASTExpr> index,
+                           std::shared_ptr<ASTExpr> col_index)
         -> std::shared_ptr<ASTVarRef>
 {
+    assert(!col_index || index);
+
     assert(name.category == Category::Identifier);
 
-    auto decl = current_scope->lookup(name.lexeme);
+    auto decl = lookup(name.lexeme);
     if(!decl)
     {
         diagman.report(source, name.location(),
@@ -348,19 +446,37 @@ auto Semantics::act_on_var(const Word& name, std::shared_ptr<ASTExpr> index)
 
     if(index && index->type() != ExprType::Int)
     {
-        diagman.report(source, index->location(), Diag::sema_index_is_not_int)
-                .range(index->source_range());
+        diagman.report(source, source_table->location(*index),
+                       Diag::sema_index_is_not_int)
+                .range(source_table->source_range(*index));
+    }
+
+    if(col_index && col_index->type() != ExprType::Int)
+    {
+        diagman.report(source, source_table->location(*col_index),
+                       Diag::sema_index_is_not_int)
+                .range(source_table->source_range(*col_index));
     }
 
     if(index && !var_decl->is_array())
     {
-        diagman.report(source, index->location(), Diag::sema_index_is_not_int)
+        diagman.report(source, source_table->location(*index),
+                       Diag::sema_index_is_not_int)
+                .range(name.lexeme);
+        index = nullptr; // recover by ignoring the indices
+        col_index = nullptr;
+    }
+
+    if(col_index && !var_decl->is_matrix())
+    {
+        diagman.report(source, source_table->location(*col_index),
+                       Diag::sema_index_is_not_int)
                 .range(name.lexeme);
-        index = nullptr; // recover by ignoring the index
+        col_index = nullptr; // recover by ignoring the column
     }
 
-    return std::make_shared<ASTVarRef>(std::move(var_decl), std::move(index),
-                                       name.lexeme);
+    return make_node<ASTVarRef>(std::move(var_decl), std::move(index), std::move(col_index),
+                                source_table->add(name.lexeme));
 }
 
 auto Semantics::act_on_call(const Word& name,
@@ -370,7 +486,7 @@ auto Semantics::act_on_call(const Word& name,
 {
     assert(name.category == Category::Identifier);
 
-    auto decl = current_scope->lookup(name.lexeme);
+    auto decl = lookup(name.lexeme);
     if(!decl)
     {
         diagman.report(source, name.location(),
@@ -417,18 +533,18 @@ auto Semantics::act_on_call(const Word& name,
 
             if(arg->type() == ExprType::Void)
             {
-                diagman.report(source, arg->location(),
+                diagman.report(source, source_table->location(*arg),
                                Diag::sema_arg_type_mismatch)
-                        .range(arg->source_range());
+                        .range(source_table->source_range(*arg));
                 continue;
             }
 
             bool is_arg_array = (arg->type() == ExprType::Array);
             if(is_arg_array != param->is_array())
             {
-                diagman.report(source, arg->location(),
+                diagman.report(source, source_table->location(*arg),
                                Diag::sema_arg_type_mismatch)
-                        .range(arg->source_range());
+                        .range(source_table->source_range(*arg));
                 continue;
             }
         }
@@ -436,7 +552,16 @@ auto Semantics::act_on_call(const Word& name,
 
     auto range = SourceRange(name.lexeme.begin(),
                              std::distance(name.lexeme.begin(), rparenloc));
-    return std::make_shared<ASTFunCall>(std::move(fun_decl), std::move(args), range);
+    return make_node<ASTFunCall>(std::move(fun_decl), std::move(args),
+                                        source_table->add(range));
+}
+
+auto Semantics::join_ranges(const ASTExpr& lhs, const ASTExpr& rhs) const
+        -> SourceRange
+{
+    auto left_loc = source_table->source_range(lhs).begin();
+    auto right_loc = source_table->source_range(rhs).end();
+    return SourceRange(left_loc, std::distance(left_loc, right_loc));
 }
 
 auto Semantics::number_from_word(const Word& word) -> int32_t
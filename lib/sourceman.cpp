@@ -3,6 +3,23 @@
 #include <cminus/sourceman.hpp>
 #include <cstring>
 
+namespace
+{
+/// \returns the number of bytes left in a stream, or `size_t(-1)` if the
+/// stream is not seekable (e.g. a pipe).
+auto remaining_size(std::FILE* stream) -> size_t
+{
+    const auto pos = std::ftell(stream);
+    if(pos < 0 || std::fseek(stream, 0, SEEK_END) != 0)
+        return size_t(-1);
+
+    const auto end = std::ftell(stream);
+    if(std::fseek(stream, pos, SEEK_SET) != 0)
+        return size_t(-1);
+    return end >= pos ? static_cast<size_t>(end - pos) : size_t(-1);
+}
+}
+
 namespace cminus
 {
 SourceFile::SourceFile(std::unique_ptr<char[]> source_data_a, size_t source_size_a) :
@@ -20,33 +37,35 @@ SourceFile::SourceFile(std::unique_ptr<char[]> source_data_a, size_t source_size
 auto SourceFile::from_stream(std::FILE* stream, size_t hint_size)
         -> std::optional<SourceFile>
 {
-    std::unique_ptr<char[]> source_data, temp_source_data;
-    size_t source_size = 0; //< not including null terminator
+    if(hint_size == size_t(-1))
+        hint_size = remaining_size(stream);
 
     // Add one to the hint_size so we can trigger EOF on the first iteration.
-    const size_t block_size = (hint_size == size_t(-1) ? 4096 : 1 + hint_size);
+    size_t capacity = (hint_size == size_t(-1) ? 4096 : 1 + hint_size);
+    size_t source_size = 0; //< not including null terminator
+
+    // Plus space for null terminator.
+    auto source_data = std::make_unique<char[]>(1 + capacity);
 
     while(true)
     {
-        auto block_pos = source_size;
-
-        // Reallocate the unique pointer (plus space for null terminator).
-        temp_source_data = std::make_unique<char[]>(1 + source_size + block_size);
-        std::memcpy(temp_source_data.get(), source_data.get(), source_size);
-        std::swap(source_data, temp_source_data);
-        source_size += block_size;
-
-        auto ncount = std::fread(&source_data[block_pos], 1, block_size, stream);
+        const auto block_size = capacity - source_size;
+        const auto ncount = std::fread(&source_data[source_size], 1, block_size, stream);
+        source_size += ncount;
 
         if(ncount < block_size)
         {
             if(std::feof(stream))
-            {
-                source_size = block_pos + ncount;
                 break;
-            }
             return std::nullopt;
         }
+
+        // Grow geometrically, so that reading takes linear time even when
+        // the size of the stream is not known beforehand.
+        capacity *= 2;
+        auto temp_source_data = std::make_unique<char[]>(1 + capacity);
+        std::memcpy(temp_source_data.get(), source_data.get(), source_size);
+        std::swap(source_data, temp_source_data);
     }
 
     source_data[source_size] = '\0';
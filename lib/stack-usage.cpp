@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cminus/stack-usage.hpp>
+#include <deque>
+
+namespace
+{
+using namespace cminus;
+
+/// Collects the functions called by a function.
+class CalleeCollector : public ASTVisitor
+{
+public:
+    void visit_call_expr(ASTFunCall& call) override
+    {
+        auto callee = call.get_decl().get();
+        if(std::find(callees.begin(), callees.end(), callee) == callees.end())
+            this->callees.push_back(callee);
+        walk_call_expr(call);
+    }
+
+public:
+    std::vector<ASTFunDecl*> callees;
+};
+
+/// Finds the strongly connected components of a graph (Tarjan's algorithm).
+class SCCFinder
+{
+public:
+    explicit SCCFinder(const std::vector<std::vector<size_t>>& succs) :
+        succs(succs),
+        index(succs.size(), unvisited),
+        lowlink(succs.size(), 0),
+        on_stack(succs.size(), false)
+    {
+    }
+
+    /// \returns the components, each successor of a node being either in
+    /// the same component or in a component that comes before.
+    auto run() -> std::vector<std::vector<size_t>>
+    {
+        for(size_t v = 0; v < succs.size(); ++v)
+        {
+            if(index[v] == unvisited)
+                visit(v);
+        }
+        return std::move(components);
+    }
+
+private:
+    void visit(size_t v)
+    {
+        this->index[v] = this->lowlink[v] = next_index++;
+        this->stack.push_back(v);
+        this->on_stack[v] = true;
+
+        for(auto w : succs[v])
+        {
+            if(index[w] == unvisited)
+            {
+                visit(w);
+                this->lowlink[v] = std::min(lowlink[v], lowlink[w]);
+            }
+            else if(on_stack[w])
+            {
+                this->lowlink[v] = std::min(lowlink[v], index[w]);
+            }
+        }
+
+        if(lowlink[v] == index[v])
+        {
+            std::vector<size_t> component;
+            size_t w;
+            do
+            {
+                w = stack.back();
+                this->stack.pop_back();
+                this->on_stack[w] = false;
+                component.push_back(w);
+            } while(w != v);
+            this->components.push_back(std::move(component));
+        }
+    }
+
+private:
+    static constexpr size_t unvisited = -1;
+
+    const std::vector<std::vector<size_t>>& succs;
+    std::vector<size_t> index;
+    std::vector<size_t> lowlink;
+    std::vector<bool> on_stack;
+    std::vector<size_t> stack;
+    size_t next_index = 0;
+    std::vector<std::vector<size_t>> components;
+};
+
+/// \returns the shortest path of nodes from `from` back to itself.
+auto find_cycle(const std::vector<std::vector<size_t>>& succs, size_t from)
+        -> std::vector<size_t>
+{
+    std::vector<size_t> parent(succs.size(), -1);
+    std::deque<size_t> queue{from};
+    while(!queue.empty())
+    {
+        const auto v = queue.front();
+        queue.pop_front();
+        for(auto w : succs[v])
+        {
+            if(w == from)
+            {
+                std::vector<size_t> path{from};
+                for(auto u = v; u != from; u = parent[u])
+                    path.push_back(u);
+                std::reverse(path.begin() + 1, path.end());
+                path.push_back(from);
+                return path;
+            }
+
+            if(parent[w] == size_t(-1))
+            {
+                parent[w] = v;
+                queue.push_back(w);
+            }
+        }
+    }
+    return {};
+}
+}
+
+namespace cminus
+{
+auto compute_stack_usage(
+        ASTProgram& program,
+        const std::unordered_map<ASTFunDecl*, ASTCodegenVisitor::FrameInfo>& frames)
+        -> std::vector<StackUsage>
+{
+    std::vector<StackUsage> usages;
+    std::unordered_map<ASTFunDecl*, size_t> fun_index;
+    for(auto it = program.decl_begin(); it != program.decl_end(); ++it)
+    {
+        if(auto fun_decl = (*it)->as_fun_decl())
+        {
+            fun_index.emplace(fun_decl.get(), usages.size());
+
+            StackUsage usage;
+            usage.fun = fun_decl.get();
+            usage.frame_size = frames.at(fun_decl.get()).total_size();
+            usages.push_back(std::move(usage));
+        }
+    }
+
+    // Builtins are not part of the call graph.
+    std::vector<std::vector<size_t>> callees(usages.size());
+    for(size_t i = 0; i < usages.size(); ++i)
+    {
+        CalleeCollector collector;
+        collector.visit_compound_stmt(*usages[i].fun->get_body());
+        for(auto callee : collector.callees)
+        {
+            auto it = fun_index.find(callee);
+            if(it != fun_index.end())
+                callees[i].push_back(it->second);
+        }
+    }
+
+    const auto to_chain = [&](const std::vector<size_t>& path) {
+        std::vector<ASTFunDecl*> chain;
+        for(auto v : path)
+            chain.push_back(usages[v].fun);
+        return chain;
+    };
+
+    // Callees are always solved before their callers, except for those
+    // in the same cycle.
+    for(const auto& component : SCCFinder(callees).run())
+    {
+        for(auto v : component)
+        {
+            auto& usage = usages[v];
+            usage.recursive = component.size() > 1
+                              || std::count(callees[v].begin(), callees[v].end(), v);
+            if(usage.recursive)
+            {
+                usage.unbounded = true;
+                usage.chain = to_chain(find_cycle(callees, v));
+            }
+        }
+
+        for(auto v : component)
+        {
+            auto& usage = usages[v];
+            if(usage.recursive)
+                continue;
+
+            usage.max_depth = usage.frame_size;
+            usage.chain = {usage.fun};
+            for(auto w : callees[v])
+            {
+                const auto& callee_usage = usages[w];
+                if(callee_usage.unbounded)
+                {
+                    if(!usage.unbounded)
+                    {
+                        usage.unbounded = true;
+                        usage.chain = {usage.fun};
+                        usage.chain.insert(usage.chain.end(),
+                                           callee_usage.chain.begin(),
+                                           callee_usage.chain.end());
+                    }
+                }
+                else if(!usage.unbounded
+                        && usage.frame_size + callee_usage.max_depth > usage.max_depth)
+                {
+                    usage.max_depth = usage.frame_size + callee_usage.max_depth;
+                    usage.chain = {usage.fun};
+                    usage.chain.insert(usage.chain.end(),
+                                       callee_usage.chain.begin(),
+                                       callee_usage.chain.end());
+                }
+            }
+        }
+    }
+
+    return usages;
+}
+}
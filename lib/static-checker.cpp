@@ -0,0 +1,98 @@
+#include <cminus/static-checker.hpp>
+
+// The checker only ever runs in constant expressions of the programs that
+// embed C- snippets, thus it is exercised here so that the library fails to
+// build should it ever stop being usable in constant expressions.
+
+namespace cminus
+{
+namespace
+{
+constexpr auto diag_of(std::string_view source) -> Diag
+{
+    const auto result = check_program(source);
+    return result.status == StaticCheckResult::Error ? result.diag : Diag::parser_expected_token;
+}
+
+static_assert(check_program(R"(
+    int gcd(int u, int v)
+    {
+        if(v == 0) return u;
+        else return gcd(v, u - u / v * v);
+    }
+
+    void main(void)
+    {
+        int x; int y;
+        x = input(); y = input();
+        println(gcd(x, y));
+    }
+)"));
+
+static_assert(check_program(R"(
+    int a[10];
+    int sum(int v[], int n)
+    {
+        int i; int s;
+        i = s = 0; /* a comment */
+        while(i < n) { s = s + v[i]; i = i + 1; }
+        return s;
+    }
+    void main(void) { println(sum(a, 10)); }
+)"));
+
+static_assert(check_program(R"(
+    int m[3][4];
+    void main(void) { m[1][2] = 3; println(m[1][2] + m[2][0]); println(m[0][0]); }
+)"));
+static_assert(diag_of("int m[3][4]; void main(void) { println(m[1]); }") == Diag::sema_arg_type_mismatch);
+static_assert(diag_of("int v[3]; void main(void) { v[1][2] = 0; }") == Diag::sema_index_is_not_int);
+
+static_assert(check_program(R"(
+    int sq(int x) [[pure, hot]] { return x * x; }
+    void fail(void) [[cold]] [[noinline]] { println(0 - 1); }
+    void main(void) { println(sq(3)); }
+)"));
+static_assert(diag_of("void main(void) [[fast]] { }") == Diag::sema_unknown_attribute);
+static_assert(diag_of("void main(void) [[hot, cold]] { }") == Diag::sema_conflicting_attributes);
+static_assert(check_program("void main(void) [[pure hot]] { }").expected == Category::CloseBracket);
+
+static_assert(check_program(R"(
+    int v[3];
+    void main(void) { int i; i = 0; v[i++] += 2; v[1] *= ++i; println(i-- - --v[0]); }
+)"));
+static_assert(diag_of("void main(void) { main()++; }") == Diag::parser_expected_lvalue);
+static_assert(diag_of("void main(void) { int a; (a) = 3; }") == Diag::parser_expected_lvalue);
+static_assert(diag_of("void main(void) { int a; ++(a); }") == Diag::parser_expected_lvalue);
+static_assert(diag_of("void main(void) { int x; x + 1 -= 2; }") == Diag::parser_expected_lvalue);
+static_assert(diag_of("void main(void) { int v[3]; --v; }") == Diag::sema_assignment_type_error);
+static_assert(diag_of("int m[2][1000000000]; void main(void) { }") == Diag::sema_array_too_large);
+static_assert(diag_of("void main(void) { int m[2147483647][2147483647]; }") == Diag::sema_array_too_large);
+static_assert(diag_of("void main(void) { int v[536870912]; }") == Diag::sema_array_too_large);
+static_assert(check_program("int m[2][268435455]; void main(void) { }"));
+
+static_assert(check_program(R"(
+    int sum(int a[], int n) { return a[0] + a[n - 1]; }
+    void main(void) { int n; n = input(); println(sum(alloc(n), n)); }
+)"));
+static_assert(diag_of("void main(void) { int x; x = alloc(2); }") == Diag::sema_assignment_type_error);
+static_assert(diag_of("void main(void) { alloc(2); }") == Diag::sema_array_statement);
+
+static_assert(diag_of("void main(void) { 1x; }") == Diag::lexer_bad_number);
+static_assert(diag_of("void main(void) { } /*") == Diag::lexer_unclosed_comment);
+static_assert(diag_of("void main(void) { 1 = 2; }") == Diag::parser_expected_lvalue);
+static_assert(check_program("void main(void) { println(1) }").expected == Category::Semicolon);
+static_assert(check_program("int x; void main(void) { y = 1; }").offset == 25);
+static_assert(diag_of("") == Diag::parser_expected_type);
+static_assert(diag_of("int main(void) { return 0; }") == Diag::sema_last_decl_not_main);
+static_assert(diag_of("void main(int x) { int x; }") == Diag::sema_redefinition);
+static_assert(diag_of("void main(void) { void x; }") == Diag::sema_var_cannot_be_void);
+static_assert(diag_of("void main(void) { println(main()); }") == Diag::sema_arg_type_mismatch);
+static_assert(diag_of("void main(void) { println(); }") == Diag::sema_arg_too_few_params);
+static_assert(diag_of("void main(void) { int a[2]; a; }") == Diag::sema_array_statement);
+static_assert(diag_of("void main(void) { return 4294967296; }") == Diag::parser_number_too_big);
+static_assert(check_program("void main(void) { {{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{{"
+                            "}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}}").status
+              == StaticCheckResult::TooLarge);
+}
+}
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cminus/mips-simulator.hpp>
+#include <cminus/sourceman.hpp>
+#include <cminus/utility/contracts.hpp>
+#include <cminus/utility/scope_guard.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace cminus;
+
+struct ExecutorOptions
+{
+    SimulationLimits limits;
+
+    /// Where to write the output of each program, if anywhere.
+    const char* output_dir = nullptr;
+
+    /// How many programs to run at once.
+    unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+/// A program to run and, once it ran, its outcome.
+struct Job
+{
+    std::string path;
+    std::optional<SimulationResult> result;
+    std::string error; //< why the program could not run, if it could not
+
+    // Errors of the system are kept as `errno` values and only described
+    // once the workers are done, as `std::strerror` is not thread-safe.
+    int read_errno = 0;   //< why the program or its input could not be read
+    int output_errno = 0; //< why its output could not be written
+};
+
+auto exit_reason_to_string(ExitReason reason) -> std::string_view
+{
+    switch(reason)
+    {
+        case ExitReason::Exit:
+            return "exit";
+        case ExitReason::InstructionBudget:
+            return "instruction-budget";
+        case ExitReason::MemoryBudget:
+            return "memory-budget";
+        case ExitReason::Fault:
+            return "fault";
+        default:
+            cminus_unreachable();
+    }
+}
+
+/// \returns the path without the extension of its file name.
+auto remove_extension(const std::string& path) -> std::string
+{
+    const auto slash = path.find_last_of('/');
+    const auto dot = path.find_last_of('.');
+    if(dot == path.npos || (slash != path.npos && dot < slash))
+        return path;
+    return path.substr(0, dot);
+}
+
+/// \returns the file name of the path, without its extension.
+auto stem(const std::string& path) -> std::string
+{
+    auto name = remove_extension(path);
+    const auto slash = name.find_last_of('/');
+    return slash == name.npos ? name : name.substr(slash + 1);
+}
+
+/// Reads a whole file.
+///
+/// \returns whether the file could be read. A missing file counts as empty
+///          if `optional`.
+bool read_file(const std::string& path, std::string& contents, bool optional)
+{
+    std::FILE* stream = fopen(path.c_str(), "rb");
+    if(stream == nullptr)
+        return optional && errno == ENOENT;
+    ScopeGuard stream_guard([&] { fclose(stream); });
+
+    auto source = SourceFile::from_stream(stream);
+    if(!source)
+        return false;
+
+    auto view = source->view_with_terminator();
+    contents.assign(view.data(), view.size() - 1);
+    return true;
+}
+
+/// Runs the program assembled in `job.path`, feeding it the file of the
+/// same name with the `.stdin` extension, if any.
+void run_job(Job& job, const ExecutorOptions& options)
+{
+    std::string source;
+    if(!read_file(job.path, source, false))
+    {
+        job.read_errno = errno;
+        return;
+    }
+
+    std::string input;
+    if(!read_file(remove_extension(job.path) + ".stdin", input, true))
+    {
+        job.read_errno = errno;
+        return;
+    }
+
+    auto program = MipsProgram::assemble(source, job.error);
+    if(!program)
+        return;
+
+    job.result = simulate(*program, input, options.limits);
+}
+
+bool write_output(const Job& job, const ExecutorOptions& options)
+{
+    assert(job.result);
+
+    const auto path = std::string(options.output_dir) + '/' + stem(job.path) + ".stdout";
+    std::FILE* ostream = fopen(path.c_str(), "wb");
+    if(ostream == nullptr)
+        return false;
+    ScopeGuard ostream_guard([&] { fclose(ostream); });
+
+    const auto& output = job.result->output;
+    return std::fwrite(output.data(), 1, output.size(), ostream) == output.size();
+}
+
+/// Runs every job and prints one line for each, in order, telling why the
+/// program stopped and how many instructions it executed.
+int executa(std::vector<Job>& jobs, const ExecutorOptions& options, std::FILE* ostream)
+{
+    // The output of each program is written by the worker that ran it, as
+    // soon as it is done, so that writing overlaps the other programs. It
+    // is not kept around afterwards.
+    std::atomic<size_t> next_job = 0;
+    auto worker = [&] {
+        for(size_t i; (i = next_job++) < jobs.size();)
+        {
+            auto& job = jobs[i];
+            run_job(job, options);
+            if(job.result && options.output_dir)
+            {
+                if(!write_output(job, options))
+                    job.output_errno = errno;
+                job.result->output = std::string();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 1; i < options.num_threads && i < jobs.size(); ++i)
+        threads.emplace_back(worker);
+    worker();
+    for(auto& thread : threads)
+        thread.join();
+
+    int exit_code = 0;
+    for(const auto& job : jobs)
+    {
+        if(!job.result)
+        {
+            const auto error = job.read_errno ? std::strerror(job.read_errno) : job.error.c_str();
+            std::fprintf(ostream, "%s error 0 %s\n", job.path.c_str(), error);
+            exit_code = 1;
+            continue;
+        }
+
+        const auto reason = exit_reason_to_string(job.result->reason);
+        std::fprintf(ostream, "%s %.*s %llu", job.path.c_str(),
+                     static_cast<int>(reason.size()), reason.data(),
+                     static_cast<unsigned long long>(job.result->instructions));
+        if(!job.result->fault.empty())
+            std::fprintf(ostream, " %s", job.result->fault.c_str());
+        std::fprintf(ostream, "\n");
+
+        if(job.output_errno)
+        {
+            std::fprintf(stderr, "executa: error: %s\n", std::strerror(job.output_errno));
+            exit_code = 1;
+        }
+    }
+
+    return exit_code;
+}
+
+/// Parses the number in an option such as `--max-memory=<bytes>`.
+bool parse_option_number(const char* arg, size_t prefix_size, uint64_t& value)
+{
+    char* end;
+    errno = 0;
+    value = std::strtoull(arg + prefix_size, &end, 10);
+    return arg[prefix_size] != '\0' && *end == '\0' && errno == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    ExecutorOptions options;
+    for(; argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0'; --argc, ++argv)
+    {
+        uint64_t value;
+        if(!strncmp(argv[1], "-j", 2) && parse_option_number(argv[1], 2, value) && value > 0)
+        {
+            options.num_threads = static_cast<unsigned>(value);
+        }
+        else if(!strncmp(argv[1], "--max-instructions=", 19)
+                && parse_option_number(argv[1], 19, value))
+        {
+            options.limits.max_instructions = value;
+        }
+        else if(!strncmp(argv[1], "--max-memory=", 13)
+                && parse_option_number(argv[1], 13, value))
+        {
+            options.limits.max_memory = value;
+        }
+        else if(!strncmp(argv[1], "--output-dir=", 13))
+        {
+            options.output_dir = argv[1] + 13;
+        }
+        else
+        {
+            std::fprintf(stderr, "executa: error: unknown option %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    if(argc < 2)
+    {
+        std::fprintf(stderr, "usage: ./executa [-j<threads>] [--max-instructions=<count>] [--max-memory=<bytes>] [--output-dir=<dir>] <asm-file>...\n");
+        return 1;
+    }
+
+    std::vector<Job> jobs(argc - 1);
+    for(int i = 1; i < argc; ++i)
+        jobs[i - 1].path = argv[i];
+
+    return executa(jobs, options, stdout);
+}
@@ -1,17 +1,34 @@
+#include <cerrno>
 #include <cminus/ast-codegen-visitor.hpp>
+#include <cminus/compilation-budget.hpp>
+#include <cminus/compilation-stats.hpp>
 #include <cminus/parser.hpp>
+#include <cminus/perf-counters.hpp>
 #include <cminus/scanner.hpp>
 #include <cminus/semantics.hpp>
+#include <cminus/stack-usage.hpp>
 #include <cminus/utility/contracts.hpp>
 #include <cminus/utility/scope_guard.hpp>
+#include <cstdlib>
 #include <cstring>
+#include <vector>
 using namespace cminus;
 
+/// The runtime shared by every program.
+///
+/// `alloc` hands out memory from chunks of at least 64 KiB taken with
+/// `sbrk`, so most calls just bump a pointer. Memory is never freed, and
+/// a size above 2^29 elements, or a negative one, goes out of bounds.
 std::string_view crt_code = R"__mips__(
+.data
+.align 2
+__crt_heap_next: .word 0
+__crt_heap_end: .word 0
+
 .text
 .globl __crt_out_of_bounds
 .globl println
-.globl input
+.globl alloc
 
 __crt_out_of_bounds:
 li $v0, 10 # exit
@@ -25,53 +42,774 @@ li $v0, 11 # print_char
 syscall
 jr $ra
 
+alloc:
+srl $t0, $a0, 29
+bnez $t0, __crt_out_of_bounds
+sll $t0, $a0, 2 # size in bytes
+lw $v0, __crt_heap_next
+lw $t1, __crt_heap_end
+subu $t2, $t1, $v0
+sltu $t2, $t2, $t0
+bnez $t2, __crt_alloc_refill
+__crt_alloc_bump:
+addu $t0, $v0, $t0
+sw $t0, __crt_heap_next
+jr $ra
+__crt_alloc_refill:
+move $t3, $a0
+move $t4, $v0
+li $a0, 0x10000
+sltu $t2, $t0, $a0
+bnez $t2, __crt_alloc_sbrk
+move $a0, $t0
+__crt_alloc_sbrk:
+addiu $a0, $a0, 4 # room for aligning the chunk
+li $v0, 9 # sbrk
+syscall
+addu $t2, $v0, $a0
+sw $t2, __crt_heap_end
+move $a0, $t3
+beq $v0, $t1, __crt_alloc_extend
+addiu $v0, $v0, 3
+li $t2, -4
+and $v0, $v0, $t2
+j __crt_alloc_bump
+__crt_alloc_extend:
+move $v0, $t4 # the new chunk follows the last one
+j __crt_alloc_bump
+)__mips__";
+
+std::string_view crt_input_code = R"__mips__(
+.text
+.globl input
+
 input:
 li $v0, 5 # read_int
 syscall
 jr $ra
 )__mips__";
 
-int codegen(std::FILE* istream, std::FILE* ostream)
+/// An alternative `input` that reads the standard input in blocks instead
+/// of issuing a syscall per call.
+///
+/// Like `read_int`, each call consumes a whole line and converts it as
+/// `atol` does: leading whitespace is skipped, followed by an optional sign
+/// and decimal digits, and anything else ends the number. An empty line or
+/// the end of the input gives 0.
+std::string_view crt_buffered_input_code = R"__mips__(
+.data
+.align 2
+__crt_input_pos: .word 0
+__crt_input_end: .word 0
+__crt_input_buf: .space 4096
+
+.text
+.globl input
+
+input:
+lw $t0, __crt_input_pos
+lw $t1, __crt_input_end
+li $t3, 0 # state: 0 = leading whitespace, 1 = number, 2 = rest of line
+li $t4, 0 # whether negative
+li $t5, 0 # value
+__crt_input_next:
+bne $t0, $t1, __crt_input_char
+move $t7, $a0 # arguments of the caller may be live
+move $t8, $a1
+move $t9, $a2
+li $a0, 0 # stdin
+la $a1, __crt_input_buf
+li $a2, 4096
+li $v0, 14 # read
+syscall
+move $a0, $t7
+move $a1, $t8
+move $a2, $t9
+blez $v0, __crt_input_done
+la $t0, __crt_input_buf
+addu $t1, $t0, $v0
+__crt_input_char:
+lbu $t2, 0($t0)
+addiu $t0, $t0, 1
+li $t6, 0x0a # '\n'
+beq $t2, $t6, __crt_input_done
+li $t6, 2
+beq $t3, $t6, __crt_input_next
+addiu $t6, $t2, -0x30 # '0'
+sltiu $t7, $t6, 10
+beqz $t7, __crt_input_nondigit
+sll $t7, $t5, 1 # value = value * 10 + digit
+sll $t5, $t5, 3
+addu $t5, $t5, $t7
+addu $t5, $t5, $t6
+li $t3, 1
+j __crt_input_next
+__crt_input_nondigit:
+bnez $t3, __crt_input_skip
+li $t6, 0x2d # '-'
+beq $t2, $t6, __crt_input_minus
+li $t6, 0x2b # '+'
+beq $t2, $t6, __crt_input_sign
+li $t6, 0x20 # ' '
+beq $t2, $t6, __crt_input_next
+addiu $t6, $t2, -0x09 # '\t', '\v', '\f' or '\r'
+sltiu $t6, $t6, 5
+bnez $t6, __crt_input_next
+__crt_input_skip:
+li $t3, 2
+j __crt_input_next
+__crt_input_minus:
+li $t4, 1
+__crt_input_sign:
+li $t3, 1
+j __crt_input_next
+__crt_input_done:
+sw $t0, __crt_input_pos
+sw $t1, __crt_input_end
+move $v0, $t5
+beqz $t4, __crt_input_return
+subu $v0, $0, $t5
+__crt_input_return:
+jr $ra
+)__mips__";
+
+/// The profiling runtime, used along with the tables emitted by the code
+/// generator under `CodegenOptions::profile`.
+///
+/// `__crt_mcount` counts a call, given the return address of the callee in
+/// `$t0` and its index in `$t1`. `__crt_mcleanup` writes the nonzero counts
+/// into `cmon.out`, one arc per line, as the caller name, the callee name
+/// and the number of calls.
+std::string_view crt_profile_code = R"__mips__(
+.data
+__crt_prof_spontaneous: .asciiz "<spontaneous>"
+__crt_prof_path: .asciiz "cmon.out"
+__crt_prof_space: .asciiz " "
+__crt_prof_digits: .space 12
+
+.text
+__crt_mcount:
+la $t2, __crt_prof_funs
+lw $t3, __crt_prof_nfuns
+li $t4, 0 # caller
+__crt_mcount_find:
+beq $t4, $t3, __crt_mcount_count
+lw $t5, 0($t2)
+sltu $t5, $t0, $t5
+bnez $t5, __crt_mcount_outside
+lw $t5, 4($t2)
+sltu $t5, $t0, $t5
+bnez $t5, __crt_mcount_count
+addiu $t4, $t4, 1
+addiu $t2, $t2, 4
+j __crt_mcount_find
+__crt_mcount_outside:
+move $t4, $t3
+__crt_mcount_count:
+mul $t4, $t4, $t3
+addu $t4, $t4, $t1
+sll $t4, $t4, 2
+la $t2, __crt_prof_arcs
+addu $t2, $t2, $t4
+lw $t5, 0($t2)
+addiu $t5, $t5, 1
+sw $t5, 0($t2)
+jr $ra
+
+__crt_mcleanup:
+addiu $sp, $sp, -24
+sw $ra, 20($sp)
+sw $s0, 16($sp)
+sw $s1, 12($sp)
+sw $s2, 8($sp)
+sw $s3, 4($sp)
+la $a0, __crt_prof_path
+li $a1, 0x241 # O_WRONLY | O_CREAT | O_TRUNC
+li $a2, 0x1a4 # 0644
+li $v0, 13 # open
+syscall
+bltz $v0, __crt_mcleanup_return
+move $s0, $v0 # file descriptor
+li $s1, 0 # caller
+__crt_mcleanup_caller:
+li $s2, 0 # callee
+__crt_mcleanup_callee:
+lw $t0, __crt_prof_nfuns
+beq $s2, $t0, __crt_mcleanup_next_caller
+mul $t1, $s1, $t0
+addu $t1, $t1, $s2
+sll $t1, $t1, 2
+la $t2, __crt_prof_arcs
+addu $t2, $t2, $t1
+lw $s3, 0($t2) # count
+beqz $s3, __crt_mcleanup_next_callee
+sll $t1, $s1, 2
+la $t2, __crt_prof_names
+addu $t2, $t2, $t1
+lw $a1, 0($t2)
+jal __crt_prof_write_str
+la $a1, __crt_prof_space
+jal __crt_prof_write_str
+sll $t1, $s2, 2
+la $t2, __crt_prof_names
+addu $t2, $t2, $t1
+lw $a1, 0($t2)
+jal __crt_prof_write_str
+la $a1, __crt_prof_space
+jal __crt_prof_write_str
+move $a1, $s3
+jal __crt_prof_write_line
+__crt_mcleanup_next_callee:
+addiu $s2, $s2, 1
+j __crt_mcleanup_callee
+__crt_mcleanup_next_caller:
+addiu $s1, $s1, 1
+ble $s1, $t0, __crt_mcleanup_caller
+move $a0, $s0
+li $v0, 16 # close
+syscall
+__crt_mcleanup_return:
+lw $s3, 4($sp)
+lw $s2, 8($sp)
+lw $s1, 12($sp)
+lw $s0, 16($sp)
+lw $ra, 20($sp)
+addiu $sp, $sp, 24
+jr $ra
+
+# Writes the string at $a1 into the file at $s0.
+__crt_prof_write_str:
+move $a2, $a1
+__crt_prof_write_str_len:
+lbu $t0, 0($a2)
+beqz $t0, __crt_prof_write_str_end
+addiu $a2, $a2, 1
+j __crt_prof_write_str_len
+__crt_prof_write_str_end:
+subu $a2, $a2, $a1
+move $a0, $s0
+li $v0, 15 # write
+syscall
+jr $ra
+
+# Writes the unsigned number in $a1 followed by a newline into the file at $s0.
+__crt_prof_write_line:
+la $a2, __crt_prof_digits
+addiu $a2, $a2, 11
+li $t0, 0x0a # '\n'
+sb $t0, 0($a2)
+li $t1, 10
+__crt_prof_write_line_digit:
+divu $a1, $t1
+mfhi $t0
+mflo $a1
+addiu $t0, $t0, 0x30 # '0'
+addiu $a2, $a2, -1
+sb $t0, 0($a2)
+bnez $a1, __crt_prof_write_line_digit
+move $a1, $a2
+la $a2, __crt_prof_digits
+addiu $a2, $a2, 12
+subu $a2, $a2, $a1
+move $a0, $s0
+li $v0, 15 # write
+syscall
+jr $ra
+)__mips__";
+
+/// How to print the statistics of a compilation.
+enum class StatsFormat
+{
+    None,
+    Text,
+    Json,
+};
+
+struct DriverOptions
+{
+    CodegenOptions codegen;
+
+    /// Where to write the line map of the generated code, if anywhere.
+    const char* line_map_path = nullptr;
+
+    /// Whether to print the stack usage of each function.
+    bool stack_usage = false;
+
+    /// Whether `input` should read the standard input in blocks.
+    bool buffered_input = false;
+
+    /// How to print the statistics of the compilation, if at all.
+    StatsFormat stats = StatsFormat::None;
+
+    /// Whether to print the hardware events of each phase of the compilation.
+    bool perf_counters = false;
+
+    /// The resources the compilation may use.
+    CompilationLimits limits;
+};
+
+/// Writes the line map of the generated code into a file.
+///
+/// Each line in the file describes where a range of lines in the generated
+/// code comes from. Profiles collected on the generated code can then be
+/// attributed back to source lines.
+bool write_line_map(const char* path,
+                    const SourceFile& source,
+                    const std::vector<ASTCodegenVisitor::LineMapEntry>& line_map)
+{
+    std::FILE* stream = fopen(path, "wb");
+    if(stream == nullptr)
+        return false;
+
+    ScopeGuard stream_guard([&] { fclose(stream); });
+
+    std::fprintf(stream, "# asm-line source-line source-column function\n");
+    for(const auto& entry : line_map)
+    {
+        if(entry.fun == nullptr)
+        {
+            std::fprintf(stream, "%u 0 0 -\n", entry.asm_line);
+            continue;
+        }
+
+        auto [line, column] = source.find_line_and_column(entry.loc);
+        auto name = entry.fun->get_name();
+        std::fprintf(stream, "%u %u %u %.*s\n", entry.asm_line, line, column,
+                     (int) name.size(), name.data());
+    }
+
+    return !ferror(stream);
+}
+
+/// Prints the worst-case stack usage of each function.
+void print_stack_usage(std::FILE* stream, const std::vector<StackUsage>& usages)
+{
+    for(const auto& usage : usages)
+    {
+        auto name = usage.fun->get_name();
+        std::fprintf(stream, "%.*s: frame %u bytes, ", (int) name.size(), name.data(),
+                     usage.frame_size);
+
+        if(usage.unbounded)
+            std::fprintf(stream, "unbounded, recursion through ");
+        else
+            std::fprintf(stream, "worst case %u bytes through ", usage.max_depth);
+
+        for(size_t i = 0; i < usage.chain.size(); ++i)
+        {
+            auto fun_name = usage.chain[i]->get_name();
+            std::fprintf(stream, "%s%.*s", (i == 0 ? "" : " -> "),
+                         (int) fun_name.size(), fun_name.data());
+        }
+        std::fprintf(stream, "\n");
+    }
+}
+
+constexpr const char* category_names[] = {
+        "Identifier", "Number", "Else", "If", "Int", "Return", "Void",
+        "While", "Plus", "Minus", "Multiply", "Divide", "Less", "LessEqual",
+        "Greater", "GreaterEqual", "Equal", "NotEqual", "Assign", "PlusAssign",
+        "MinusAssign", "MultiplyAssign", "DivideAssign", "Increment",
+        "Decrement", "Semicolon", "Comma", "OpenParen", "CloseParen",
+        "OpenBracket", "CloseBracket", "OpenCurly", "CloseCurly", "Eof",
+};
+
+constexpr const char* decl_kind_names[] = {
+        "VarDecl", "ParmVarDecl", "FunDecl",
+};
+
+constexpr const char* stmt_kind_names[] = {
+        "NullStmt", "ExprStmt", "CompoundStmt", "SelectionStmt",
+        "IterationStmt", "ReturnStmt",
+};
+
+constexpr const char* expr_kind_names[] = {
+        "Number", "VarRef", "FunCall", "BinaryExpr", "AssignExpr",
+        "CompoundAssignExpr",
+};
+
+static_assert(std::size(category_names) == sizeof(ScannerStats::words) / sizeof(uint32_t));
+static_assert(std::size(decl_kind_names) == sizeof(CompilationStats::decls) / sizeof(uint32_t));
+static_assert(std::size(stmt_kind_names) == sizeof(CompilationStats::stmts) / sizeof(uint32_t));
+static_assert(std::size(expr_kind_names) == sizeof(CompilationStats::exprs) / sizeof(uint32_t));
+
+void print_stats_text(std::FILE* stream, const CompilationStats& stats)
+{
+    auto print_counts = [&](const char* title, const char* const* names,
+                            const uint32_t* counts, size_t size) {
+        std::fprintf(stream, "%s:\n", title);
+        for(size_t i = 0; i < size; ++i)
+        {
+            if(counts[i] != 0)
+                std::fprintf(stream, "  %-16s %u\n", names[i], counts[i]);
+        }
+    };
+
+    print_counts("tokens", category_names, stats.scanner.words, std::size(stats.scanner.words));
+    print_counts("declarations", decl_kind_names, stats.decls, std::size(stats.decls));
+    print_counts("statements", stmt_kind_names, stats.stmts, std::size(stats.stmts));
+    print_counts("expressions", expr_kind_names, stats.exprs, std::size(stats.exprs));
+
+    std::fprintf(stream, "scopes: %u\n", stats.sema.scopes);
+    std::fprintf(stream, "lookups: %u\n", stats.sema.lookups);
+    std::fprintf(stream, "lookup misses: %u\n", stats.sema.lookup_misses);
+
+    std::fprintf(stream, "functions: %zu\n", stats.frames.size());
+    for(const auto& [fun, frame] : stats.frames)
+    {
+        auto name = fun->get_name();
+        std::fprintf(stream, "  %.*s: frame %u bytes (output %d, temp %d, saved %d, local %d, input %d)\n",
+                     (int) name.size(), name.data(), frame.total_size(),
+                     frame.output_size, frame.temp_size, frame.saved_size,
+                     frame.local_size, frame.input_size);
+    }
+
+    uint32_t total = 0;
+    for(const auto& [opcode, count] : stats.instructions)
+        total += count;
+    std::fprintf(stream, "instructions: %u\n", total);
+    for(const auto& [opcode, count] : stats.instructions)
+        std::fprintf(stream, "  %-16s %u\n", opcode.c_str(), count);
+
+    std::fprintf(stream, "labels: %u\n", stats.labels);
+}
+
+void print_stats_json(std::FILE* stream, const CompilationStats& stats)
+{
+    auto print_counts = [&](const char* title, const char* const* names,
+                            const uint32_t* counts, size_t size) {
+        std::fprintf(stream, "  \"%s\": {", title);
+        const char* separator = "";
+        for(size_t i = 0; i < size; ++i)
+        {
+            if(counts[i] != 0)
+            {
+                std::fprintf(stream, "%s\"%s\": %u", separator, names[i], counts[i]);
+                separator = ", ";
+            }
+        }
+        std::fprintf(stream, "},\n");
+    };
+
+    std::fprintf(stream, "{\n");
+    print_counts("tokens", category_names, stats.scanner.words, std::size(stats.scanner.words));
+    print_counts("declarations", decl_kind_names, stats.decls, std::size(stats.decls));
+    print_counts("statements", stmt_kind_names, stats.stmts, std::size(stats.stmts));
+    print_counts("expressions", expr_kind_names, stats.exprs, std::size(stats.exprs));
+
+    std::fprintf(stream, "  \"scopes\": %u,\n", stats.sema.scopes);
+    std::fprintf(stream, "  \"lookups\": %u,\n", stats.sema.lookups);
+    std::fprintf(stream, "  \"lookup_misses\": %u,\n", stats.sema.lookup_misses);
+
+    std::fprintf(stream, "  \"functions\": [");
+    for(size_t i = 0; i < stats.frames.size(); ++i)
+    {
+        const auto& [fun, frame] = stats.frames[i];
+        auto name = fun->get_name();
+        std::fprintf(stream, "%s\n    {\"name\": \"%.*s\", \"frame_size\": %u, "
+                             "\"output_size\": %d, \"temp_size\": %d, \"saved_size\": %d, "
+                             "\"local_size\": %d, \"input_size\": %d}",
+                     (i == 0 ? "" : ","), (int) name.size(), name.data(),
+                     frame.total_size(), frame.output_size, frame.temp_size,
+                     frame.saved_size, frame.local_size, frame.input_size);
+    }
+    std::fprintf(stream, "\n  ],\n");
+
+    std::fprintf(stream, "  \"instructions\": {");
+    const char* separator = "";
+    for(const auto& [opcode, count] : stats.instructions)
+    {
+        std::fprintf(stream, "%s\"%s\": %u", separator, opcode.c_str(), count);
+        separator = ", ";
+    }
+    std::fprintf(stream, "},\n");
+
+    std::fprintf(stream, "  \"labels\": %u\n", stats.labels);
+    std::fprintf(stream, "}\n");
+}
+
+/// Counts the hardware events in each phase of the compilation, if enabled.
+class PhaseCounters
+{
+public:
+    explicit PhaseCounters(bool enabled)
+    {
+        if(enabled)
+            this->counters.emplace();
+    }
+
+    /// Ends the current phase, if any, and begins another.
+    void begin(const char* phase)
+    {
+        end();
+        if(counters)
+        {
+            this->current_phase = phase;
+            this->phase_start = counters->read();
+        }
+    }
+
+    /// Ends the current phase.
+    void end()
+    {
+        if(!counters || !current_phase)
+            return;
+
+        auto sample = counters->read();
+        for(size_t i = 0; i < PerfCounters::NumEvents; ++i)
+        {
+            if(sample.values[i] && phase_start.values[i])
+                sample.values[i] = *sample.values[i] - *phase_start.values[i];
+            else
+                sample.values[i] = std::nullopt;
+        }
+        this->phases.emplace_back(current_phase, sample);
+        this->current_phase = nullptr;
+    }
+
+    void print(std::FILE* stream) const
+    {
+        if(!counters)
+            return;
+
+        if(!counters->available())
+        {
+            std::fprintf(stream, "geracodigo: warning: performance counters are unavailable\n");
+            return;
+        }
+
+        std::fprintf(stream, "%-12s", "phase");
+        for(size_t i = 0; i < PerfCounters::NumEvents; ++i)
+            std::fprintf(stream, " %14s", PerfCounters::event_name(PerfCounters::Event(i)));
+        std::fprintf(stream, "\n");
+
+        for(const auto& [phase, sample] : phases)
+        {
+            std::fprintf(stream, "%-12s", phase);
+            for(const auto& value : sample.values)
+            {
+                if(value)
+                    std::fprintf(stream, " %14llu", static_cast<unsigned long long>(*value));
+                else
+                    std::fprintf(stream, " %14s", "n/a");
+            }
+            std::fprintf(stream, "\n");
+        }
+    }
+
+private:
+    std::optional<PerfCounters> counters;
+    std::vector<std::pair<const char*, PerfCounters::Sample>> phases;
+    const char* current_phase = nullptr;
+    PerfCounters::Sample phase_start;
+};
+
+/// Tells why the compilation was abandoned.
+int report_budget_exhausted(const CompilationBudget& budget)
+{
+    const auto reason = CompilationBudget::reason_name(budget.get_reason());
+    std::fprintf(stderr, "geracodigo: error: compilation budget exhausted (%.*s)\n",
+                 static_cast<int>(reason.size()), reason.data());
+    return 1;
+}
+
+int codegen(std::FILE* istream, std::FILE* ostream, const DriverOptions& options)
 {
     bool error = false;
     DiagnosticManager diagman;
+    PhaseCounters phases(options.perf_counters);
+    CompilationBudget budget(options.limits);
 
+    phases.begin("load");
     auto source = SourceFile::from_stream(istream);
     if(!source)
     {
         std::perror("geracodigo: error");
         return 1;
     }
+    budget.charge_memory(source->view_with_terminator().size());
+
+    // Scanning happens along with parsing, so it is measured on its own
+    // in an extra pass. Its diagnostics are reported again while parsing,
+    // and its work is not charged to the budget, which accounts for the
+    // compilation alone.
+    if(options.perf_counters)
+    {
+        phases.begin("lex");
+        DiagnosticManager lex_diagman;
+        lex_diagman.handler([](const Diagnostic&) { return false; });
+        Scanner scanner(*source, lex_diagman);
+        while(scanner.next_word().category != Category::Eof)
+        {
+        }
+    }
 
     diagman.handler([&](const Diagnostic&) {
         error = true;
         return true;
     });
 
+    CompilationStats stats;
     Scanner scanner(*source, diagman);
     Semantics sema(*source, diagman);
     Parser parser(scanner, sema, diagman);
+    scanner.set_budget(budget);
+    sema.set_budget(budget);
+    parser.set_budget(budget);
+    if(options.stats != StatsFormat::None)
+    {
+        scanner.record_stats(stats.scanner);
+        sema.record_stats(stats.sema);
+    }
 
+    phases.begin("parse+sema");
     if(auto ast = parser.parse_program())
     {
         if(!error)
         {
             std::string codegen;
-            ASTCodegenVisitor visitor(codegen);
+            std::vector<ASTCodegenVisitor::LineMapEntry> line_map;
+            ASTCodegenVisitor visitor(codegen, options.codegen);
+            if(options.line_map_path)
+                visitor.record_line_map(line_map);
+            visitor.set_budget(budget);
+
+            phases.begin("emission");
             visitor.visit_program(*ast);
+
+            // The generated code is incomplete, so it must not be written.
+            if(budget.exhausted())
+            {
+                diagman.report(*source, Diag::budget_exhausted);
+                return report_budget_exhausted(budget);
+            }
+
+            phases.begin("output");
             std::fprintf(ostream, "%s\n", codegen.c_str());
+            const auto input_code = options.buffered_input ? crt_buffered_input_code
+                                                           : crt_input_code;
             std::fprintf(ostream, "%*s\n", (int) crt_code.size(), crt_code.data());
+            std::fprintf(ostream, "%*s\n", (int) input_code.size(), input_code.data());
+            if(options.codegen.profile)
+                std::fprintf(ostream, "%*s\n", (int) crt_profile_code.size(), crt_profile_code.data());
+            std::fflush(ostream);
+            phases.end();
+
+            if(options.line_map_path
+               && !write_line_map(options.line_map_path, *source, line_map))
+            {
+                std::perror("geracodigo: error");
+                return 1;
+            }
+
+            if(options.stack_usage)
+                print_stack_usage(stderr, compute_stack_usage(*ast, visitor.get_frames()));
+
+            if(options.stats != StatsFormat::None)
+            {
+                collect_ast_stats(*ast, stats);
+                collect_codegen_stats(*ast, visitor.get_frames(), codegen, stats);
+                if(options.stats == StatsFormat::Json)
+                    print_stats_json(stderr, stats);
+                else
+                    print_stats_text(stderr, stats);
+            }
         }
     }
 
+    phases.end();
+    phases.print(stderr);
+
+    if(budget.exhausted())
+        return report_budget_exhausted(budget);
     return 0;
 }
 
+/// Parses the number in an option such as `--max-memory=<bytes>`.
+bool parse_option_number(const char* arg, size_t prefix_size, uint64_t& value)
+{
+    char* end;
+    errno = 0;
+    value = std::strtoull(arg + prefix_size, &end, 10);
+    return arg[prefix_size] != '\0' && *end == '\0' && errno == 0;
+}
+
 int main(int argc, char* argv[])
 {
+    DriverOptions options;
+    for(; argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0'; --argc, ++argv)
+    {
+        uint64_t value;
+        if(!strcmp(argv[1], "-O"))
+        {
+            options.codegen.optimize = true;
+        }
+        else if(!strcmp(argv[1], "-fno-omit-frame-pointer"))
+        {
+            options.codegen.frame_pointer = true;
+        }
+        else if(!strcmp(argv[1], "-fomit-frame-pointer"))
+        {
+            options.codegen.frame_pointer = false;
+        }
+        else if(!strncmp(argv[1], "--line-map=", 11))
+        {
+            options.line_map_path = argv[1] + 11;
+        }
+        else if(!strcmp(argv[1], "--stack-usage"))
+        {
+            options.stack_usage = true;
+        }
+        else if(!strcmp(argv[1], "-pg"))
+        {
+            options.codegen.profile = true;
+        }
+        else if(!strcmp(argv[1], "--stats") || !strcmp(argv[1], "--stats=text"))
+        {
+            options.stats = StatsFormat::Text;
+        }
+        else if(!strcmp(argv[1], "--stats=json"))
+        {
+            options.stats = StatsFormat::Json;
+        }
+        else if(!strcmp(argv[1], "-fperf-counters"))
+        {
+            options.perf_counters = true;
+        }
+        else if(!strcmp(argv[1], "-fbuffered-input"))
+        {
+            options.buffered_input = true;
+        }
+        else if(!strncmp(argv[1], "--max-time=", 11)
+                && parse_option_number(argv[1], 11, value))
+        {
+            options.limits.max_time_ms = value;
+        }
+        else if(!strncmp(argv[1], "--max-memory=", 13)
+                && parse_option_number(argv[1], 13, value))
+        {
+            options.limits.max_memory = value;
+        }
+        else if(!strncmp(argv[1], "--max-ast-nodes=", 16)
+                && parse_option_number(argv[1], 16, value))
+        {
+            options.limits.max_ast_nodes = value;
+        }
+        else if(!strncmp(argv[1], "--max-output=", 13)
+                && parse_option_number(argv[1], 13, value))
+        {
+            options.limits.max_output = value;
+        }
+        else
+        {
+            std::fprintf(stderr, "geracodigo: error: unknown option %s\n", argv[1]);
+            return 1;
+        }
+    }
+
     if(argc < 3)
     {
-        std::fprintf(stderr, "usage: ./geracodigo <source-file> <out-file>\n");
+        std::fprintf(stderr, "usage: ./geracodigo [-O] [-fno-omit-frame-pointer] [-pg] [--line-map=<map-file>] [--stack-usage] [--stats[=json]] [-fperf-counters] [-fbuffered-input] [--max-time=<ms>] [--max-memory=<bytes>] [--max-ast-nodes=<count>] [--max-output=<bytes>] <source-file> <out-file>\n");
         return 1;
     }
 
@@ -111,5 +849,5 @@ int main(int argc, char* argv[])
         }
     }
 
-    return codegen(istream, ostream);
+    return codegen(istream, ostream, options);
 }
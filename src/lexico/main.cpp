@@ -30,6 +30,12 @@ auto category_to_string(Category category) -> std::string_view
         case Category::Equal:
         case Category::NotEqual:
         case Category::Assign:
+        case Category::PlusAssign:
+        case Category::MinusAssign:
+        case Category::MultiplyAssign:
+        case Category::DivideAssign:
+        case Category::Increment:
+        case Category::Decrement:
         case Category::Semicolon:
         case Category::Comma:
         case Category::OpenParen:
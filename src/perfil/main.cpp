@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cctype>
+#include <cminus/utility/scope_guard.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace cminus;
+
+/// A number of calls from a function to another.
+struct Arc
+{
+    size_t caller;
+    size_t callee;
+    uint64_t count;
+};
+
+/// The calls made to and from a function.
+struct FunProfile
+{
+    std::string name;
+    uint64_t calls = 0;           //< calls from other functions
+    uint64_t recursive_calls = 0; //< calls from the function itself
+    std::vector<size_t> parents;  //< arcs into the function
+    std::vector<size_t> children; //< arcs out of the function
+    size_t index = 0;             //< position in the call graph, from 1
+
+    auto total_calls() const -> uint64_t
+    {
+        return calls + recursive_calls;
+    }
+};
+
+/// Reads a whitespace separated word.
+auto read_word(std::FILE* stream) -> std::optional<std::string>
+{
+    int c;
+    while((c = std::fgetc(stream)) != EOF && std::isspace(c))
+    {
+    }
+
+    if(c == EOF)
+        return std::nullopt;
+
+    std::string word;
+    do
+    {
+        word.push_back(static_cast<char>(c));
+    } while((c = std::fgetc(stream)) != EOF && !std::isspace(c));
+    return word;
+}
+
+/// Reads the arcs of a profile written by a program built with `-pg`.
+bool read_profile(std::FILE* istream,
+                  std::vector<FunProfile>& funs,
+                  std::vector<Arc>& arcs)
+{
+    std::unordered_map<std::string, size_t> fun_index;
+    auto find_fun = [&](std::string name) {
+        auto [it, inserted] = fun_index.emplace(name, funs.size());
+        if(inserted)
+        {
+            FunProfile fun;
+            fun.name = std::move(name);
+            funs.push_back(std::move(fun));
+        }
+        return it->second;
+    };
+
+    while(auto caller = read_word(istream))
+    {
+        auto callee = read_word(istream);
+        auto count = read_word(istream);
+        if(!callee || !count || count->find_first_not_of("0123456789") != std::string::npos)
+            return false;
+
+        Arc arc;
+        arc.caller = find_fun(std::move(*caller));
+        arc.callee = find_fun(std::move(*callee));
+        arc.count = std::strtoull(count->c_str(), nullptr, 10);
+
+        auto& callee_fun = funs[arc.callee];
+        if(arc.caller == arc.callee)
+            callee_fun.recursive_calls += arc.count;
+        else
+            callee_fun.calls += arc.count;
+
+        funs[arc.caller].children.push_back(arcs.size());
+        callee_fun.parents.push_back(arcs.size());
+        arcs.push_back(arc);
+    }
+
+    return true;
+}
+
+int perfil(std::FILE* istream, std::FILE* ostream)
+{
+    std::vector<FunProfile> funs;
+    std::vector<Arc> arcs;
+    if(!read_profile(istream, funs, arcs))
+    {
+        std::fprintf(stderr, "perfil: error: malformed profile\n");
+        return 1;
+    }
+
+    // Functions never called (i.e. the spontaneous caller) are not listed.
+    std::vector<size_t> order;
+    uint64_t total_calls = 0;
+    for(size_t i = 0; i < funs.size(); ++i)
+    {
+        if(funs[i].total_calls() != 0)
+        {
+            order.push_back(i);
+            total_calls += funs[i].total_calls();
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return funs[lhs].total_calls() > funs[rhs].total_calls();
+    });
+    for(size_t i = 0; i < order.size(); ++i)
+        funs[order[i]].index = i + 1;
+
+    std::fprintf(ostream, "Flat profile:\n\n");
+    std::fprintf(ostream, "%7s %10s %10s  %s\n", "% calls", "calls", "recursive", "name");
+    for(auto i : order)
+    {
+        const auto& fun = funs[i];
+        std::fprintf(ostream, "%7.2f %10llu %10llu  %s\n",
+                     100.0 * fun.total_calls() / total_calls,
+                     static_cast<unsigned long long>(fun.total_calls()),
+                     static_cast<unsigned long long>(fun.recursive_calls),
+                     fun.name.c_str());
+    }
+
+    auto print_arc = [&](uint64_t count, uint64_t total, const FunProfile& fun) {
+        auto calls = std::to_string(count) + '/' + std::to_string(total);
+        std::fprintf(ostream, "%6s %16s      %s", "", calls.c_str(), fun.name.c_str());
+        if(fun.index != 0)
+            std::fprintf(ostream, " [%zu]", fun.index);
+        std::fprintf(ostream, "\n");
+    };
+
+    // Each entry lists the callers of a function above it, along with how
+    // many of its calls come from each, and the functions it calls below it,
+    // along with how many of their calls come from this function.
+    std::fprintf(ostream, "\nCall graph:\n\n");
+    std::fprintf(ostream, "%-6s %16s      %s\n", "index", "called", "name");
+    for(auto i : order)
+    {
+        const auto& fun = funs[i];
+        for(auto arc_index : fun.parents)
+        {
+            const auto& arc = arcs[arc_index];
+            if(arc.caller != i)
+                print_arc(arc.count, fun.calls, funs[arc.caller]);
+        }
+
+        auto index = '[' + std::to_string(fun.index) + ']';
+        auto calls = std::to_string(fun.calls);
+        if(fun.recursive_calls != 0)
+            calls += '+' + std::to_string(fun.recursive_calls);
+        std::fprintf(ostream, "%-6s %16s    %s [%zu]\n",
+                     index.c_str(), calls.c_str(), fun.name.c_str(), fun.index);
+
+        for(auto arc_index : fun.children)
+        {
+            const auto& arc = arcs[arc_index];
+            if(arc.callee != i)
+                print_arc(arc.count, funs[arc.callee].calls, funs[arc.callee]);
+        }
+
+        std::fprintf(ostream, "-----------------------------------------------\n");
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        std::fprintf(stderr, "usage: ./perfil <profile-file> <out-file>\n");
+        return 1;
+    }
+
+    std::FILE* ostream;
+    ScopeGuard ostream_guard([&] { fclose(ostream); });
+    if(!strcmp(argv[2], "-"))
+    {
+        ostream = stdout;
+        ostream_guard.dismiss();
+    }
+    else
+    {
+        ostream = fopen(argv[2], "wb");
+        if(ostream == nullptr)
+        {
+            ostream_guard.dismiss();
+            std::perror("perfil: error");
+            return 1;
+        }
+    }
+
+    std::FILE* istream;
+    ScopeGuard istream_guard([&] { fclose(istream); });
+    if(!strcmp(argv[1], "-"))
+    {
+        istream = stdin;
+        istream_guard.dismiss();
+    }
+    else
+    {
+        istream = fopen(argv[1], "rb");
+        if(istream == nullptr)
+        {
+            istream_guard.dismiss();
+            std::perror("perfil: error");
+            return 1;
+        }
+    }
+
+    return perfil(istream, ostream);
+}
@@ -7,7 +7,7 @@
 #include <cstring>
 using namespace cminus;
 
-int sintatico(std::FILE* istream, std::FILE* ostream)
+int sintatico(std::FILE* istream, std::FILE* ostream, bool syntax_only)
 {
     bool error = false;
     DiagnosticManager diagman;
@@ -19,6 +19,10 @@ int sintatico(std::FILE* istream, std::FILE* ostream)
         return 1;
     }
 
+    // Only the exit status tells the result in this mode.
+    if(syntax_only)
+        return check_syntax(*source) ? 0 : 1;
+
     diagman.handler([&](const Diagnostic&) {
         error = true;
         return true;
@@ -44,15 +48,25 @@ int sintatico(std::FILE* istream, std::FILE* ostream)
 
 int main(int argc, char* argv[])
 {
-    if(argc < 3)
+    bool syntax_only = false;
+    if(argc > 1 && !strcmp(argv[1], "--syntax-only"))
+    {
+        syntax_only = true;
+        --argc;
+        ++argv;
+    }
+
+    // Nothing is written when only checking the syntax.
+    if(argc < (syntax_only ? 2 : 3))
     {
-        std::fprintf(stderr, "usage: ./sintatico <source-file> <out-file>\n");
+        std::fprintf(stderr, "usage: ./sintatico <source-file> <out-file>\n"
+                             "       ./sintatico --syntax-only <source-file>\n");
         return 1;
     }
 
     std::FILE* ostream;
     ScopeGuard ostream_guard([&] { fclose(ostream); });
-    if(!strcmp(argv[2], "-"))
+    if(syntax_only || !strcmp(argv[2], "-"))
     {
         ostream = stdout;
         ostream_guard.dismiss();
@@ -86,5 +100,5 @@ int main(int argc, char* argv[])
         }
     }
 
-    return sintatico(istream, ostream);
+    return sintatico(istream, ostream, syntax_only);
 }
@@ -0,0 +1,7 @@
+.text
+main:
+li $a0, 1
+li $v0, 1 # print_int
+syscall
+.Lloop:
+j .Lloop
@@ -0,0 +1,5 @@
+.text
+main:
+addiu $sp, $sp, -1024
+sw $ra, 0($sp)
+jal main
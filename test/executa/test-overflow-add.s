@@ -0,0 +1,16 @@
+# Unsigned additions wrap around, whereas add traps on signed overflow.
+.text
+main:
+li $t0, 0x7fffffff
+addiu $a0, $t0, 1
+li $v0, 1 # print_int
+syscall
+li $t1, -1
+add $a0, $t0, $t1
+li $v0, 1 # print_int
+syscall
+li $t1, 1
+add $a0, $t0, $t1
+li $v0, 1 # print_int
+syscall
+jr $ra
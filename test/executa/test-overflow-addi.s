@@ -0,0 +1,14 @@
+# addi traps on signed overflow, unlike addiu.
+.text
+main:
+li $t0, 0x80000000
+addiu $a0, $t0, -1
+li $v0, 1 # print_int
+syscall
+addi $a0, $t0, 1
+li $v0, 1 # print_int
+syscall
+addi $a0, $t0, -1
+li $v0, 1 # print_int
+syscall
+jr $ra
@@ -0,0 +1,12 @@
+# sub traps on signed overflow, and so does negating the smallest integer.
+.text
+main:
+li $t0, 0x80000000
+li $t1, 1
+subu $a0, $t0, $t1
+li $v0, 1 # print_int
+syscall
+sub $a0, $t1, $t0
+li $v0, 1 # print_int
+syscall
+jr $ra
@@ -0,0 +1,5 @@
+.text
+main:
+addiu $sp, $sp, -8
+frobnicate $t0
+jr $ra
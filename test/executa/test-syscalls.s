@@ -0,0 +1,39 @@
+# Sums the numbers in the input, one per line, until a zero.
+.data
+message: .asciiz "sum: "
+digits: .byte '0', '1', '2'
+
+.text
+.globl main
+
+main:
+li $t0, 0
+.Lread:
+li $v0, 5 # read_int
+syscall
+beqz $v0, .Lprint
+addu $t0, $t0, $v0
+j .Lread
+.Lprint:
+la $a0, message
+li $v0, 4 # print_string
+syscall
+move $a0, $t0
+li $v0, 1 # print_int
+syscall
+li $a0, 0x0a
+li $v0, 11 # print_char
+syscall
+li $a0, 16
+li $v0, 9 # sbrk
+syscall
+lbu $t1, digits+2
+sb $t1, 0($v0)
+li $a0, 1 # stdout
+move $a1, $v0
+li $a2, 1
+li $v0, 15 # write
+syscall
+li $a0, 0
+li $v0, 17 # exit2
+syscall
@@ -0,0 +1,8 @@
+.data
+value: .word 42
+
+.text
+main:
+la $t0, value
+lw $a0, 2($t0)
+jr $ra
@@ -0,0 +1,21 @@
+#!/bin/sh
+EXECUTA=../../executa
+tempfile=$(mktemp)
+tempdir=$(mktemp -d)
+exit_code=0
+for asmfile in *.s; do
+    [ -f "$asmfile" ] || break
+    outfile="${asmfile%.*}.out"
+
+    printf "Testing $asmfile... "
+    if { $EXECUTA --max-instructions=100000 --max-memory=65536 --output-dir="$tempdir" "$asmfile"; cat "$tempdir/${asmfile%.*}.stdout" 2>/dev/null; } | diff - "$outfile" >$tempfile; then
+        printf "\033[0;32mOK\033[0m\n"
+    else
+        printf "\033[0;31mFAILED\033[0m\n"
+        cat "$tempfile"
+        exit_code=1
+    fi
+done
+rm -r "$tempdir"
+rm "$tempfile"
+exit $exit_code
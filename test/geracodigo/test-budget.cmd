@@ -0,0 +1,20 @@
+# The gcd program takes 366 bytes of source, 49 AST nodes and 1204 bytes of
+# generated code, so it just fits.
+$GERACODIGO --max-time=60000 --max-memory=100000 --max-ast-nodes=49 --max-output=1204 test-program-gcd.in "$SCRATCH/out.s"
+$GERACODIGO test-program-gcd.in - | cmp - "$SCRATCH/out.s"
+
+# Exhausting any budget leaves the output empty.
+for limit in --max-memory=365 --max-ast-nodes=48 --max-output=1203; do
+    $GERACODIGO $limit test-program-gcd.in "$SCRATCH/out.s"
+    echo "exit: $?"
+    if [ -s "$SCRATCH/out.s" ]; then echo "output written"; fi
+done
+
+awk 'BEGIN {
+    print "void main(void) { int x; x = 0;";
+    for(i = 0; i < 20000; ++i) print "x = x + 1;";
+    print "println(x); }";
+}' > "$SCRATCH/long.in"
+$GERACODIGO --max-time=1 "$SCRATCH/long.in" "$SCRATCH/out.s"
+echo "exit: $?"
+if [ -s "$SCRATCH/out.s" ]; then echo "output written"; fi
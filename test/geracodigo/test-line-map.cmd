@@ -0,0 +1 @@
+$GERACODIGO --line-map="$SCRATCH/map" test-program-gcd.in "$SCRATCH/out.s" && cat "$SCRATCH/map"
@@ -0,0 +1,3 @@
+# The source file takes the last descriptor left, so no counter can be opened.
+( ulimit -n 4; exec $GERACODIGO -fperf-counters test-program-gcd.in - ) > "$SCRATCH/out.s"
+$GERACODIGO test-program-gcd.in - | cmp - "$SCRATCH/out.s"
@@ -0,0 +1,2 @@
+$GERACODIGO --stack-usage test-stack-usage.in "$SCRATCH/out.s"
+$GERACODIGO --stack-usage -fno-omit-frame-pointer test-stack-usage.in "$SCRATCH/out.s"
@@ -0,0 +1,2 @@
+$GERACODIGO --stats test-program-gcd.in "$SCRATCH/out.s"
+$GERACODIGO --stats=json test-program-gcd.in "$SCRATCH/out.s"
@@ -2,14 +2,36 @@
 GERACODIGO=../../geracodigo
 tempfile=$(mktemp)
 tempout=$(mktemp)
+tempdir=$(mktemp -d)
 exit_code=0
 for infile in *.in; do
     [ -f "$infile" ] || break
     stdin_file="${infile%.*}.stdin"
     stdout_file="${infile%.*}.stdout"
 
-    printf "Testing $infile... "
-    if $GERACODIGO "$infile" "$tempout" && spim -f "$tempout" < "$stdin_file" | sed -e '0,/^Loaded:/d' | diff - "$stdout_file" >$tempfile; then
+    # The generated code must behave the same regardless of code generation flags.
+    for flags in "" "-O" "-fno-omit-frame-pointer" "-fbuffered-input" "-pg"; do
+        printf "Testing $infile $flags... "
+        if $GERACODIGO $flags "$infile" "$tempout" && spim -f "$tempout" < "$stdin_file" | sed -e '0,/^Loaded:/d' | diff - "$stdout_file" >$tempfile; then
+            printf "\033[0;32mOK\033[0m\n"
+        else
+            printf "\033[0;31mFAILED\033[0m\n"
+            cat "$tempfile"
+            exit_code=1
+        fi
+    done
+done
+
+# Driver options are checked by running the commands in each .cmd file, with
+# the compiler in $GERACODIGO and an empty scratch directory in $SCRATCH, and
+# comparing what they print, followed by their exit status, with the .out file.
+for cmdfile in *.cmd; do
+    [ -f "$cmdfile" ] || break
+    out_file="${cmdfile%.*}.out"
+
+    printf "Testing $cmdfile... "
+    rm -f "$tempdir"/*
+    if { GERACODIGO="$GERACODIGO" SCRATCH="$tempdir" sh "$cmdfile" 2>&1; echo "exit: $?"; } | diff - "$out_file" >$tempfile; then
         printf "\033[0;32mOK\033[0m\n"
     else
         printf "\033[0;31mFAILED\033[0m\n"
@@ -17,6 +39,8 @@ for infile in *.in; do
         exit_code=1
     fi
 done
+rm -r "$tempdir"
 rm "$tempout"
 rm "$tempfile"
+rm -f cmon.out
 exit $exit_code
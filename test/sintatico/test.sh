@@ -16,6 +16,21 @@ for infile in *.in; do
         cat "$tempfile"
         exit_code=1
     fi
+
+    # Sources with an expected exit status are checked by --syntax-only as well.
+    statusfile="${infile%.*}.status"
+    if [ -f "$statusfile" ]; then
+        printf "Testing $infile --syntax-only... "
+        $SINTATICO --syntax-only "$infile"
+        status=$?
+        if [ "$status" = "$(cat "$statusfile")" ]; then
+            printf "\033[0;32mOK\033[0m\n"
+        else
+            printf "\033[0;31mFAILED\033[0m\n"
+            echo "exit status $status, expected $(cat "$statusfile")"
+            exit_code=1
+        fi
+    fi
 done
 rm "$tempout"
 rm "$tempfile"
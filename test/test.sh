@@ -12,4 +12,12 @@ echo "Testing code generation..."
 cd geracodigo
 sh ./test.sh
 cd ..
+echo "Testing profiler..."
+cd perfil
+sh ./test.sh
+cd ..
+echo "Testing simulator..."
+cd executa
+sh ./test.sh
+cd ..
 cd ..